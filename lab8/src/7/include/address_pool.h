@@ -9,6 +9,12 @@ class AddressPool
 public:
     BitMap resources;
     int startAddress;
+    // 分配成功的次数
+    int allocations;
+    // 分配失败的次数
+    int failures;
+    // 释放的次数
+    int releases;
 
 public:
     AddressPool();
@@ -18,6 +24,8 @@ public:
     int allocate(const int count);
     // 释放若干页的空间
     void release(const int address, const int amount);
+    // 将从address开始的amount个页标记为已分配
+    void reserve(const int address, const int amount);
 };
 
 #endif
\ No newline at end of file
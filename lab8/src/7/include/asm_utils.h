@@ -7,6 +7,7 @@ extern "C" void asm_hello_world();
 extern "C" void asm_lidt(uint32 start, uint16 limit);
 extern "C" void asm_unhandled_interrupt();
 extern "C" void asm_halt();
+extern "C" void asm_idle();
 extern "C" void asm_out_port(uint16 port, uint8 value);
 extern "C" void asm_in_port(uint16 port, uint8 *value);
 extern "C" void asm_enable_interrupt();
@@ -22,5 +23,22 @@ extern "C" int asm_add_global_descriptor(int low, int high);
 extern "C" void asm_ltr(int tr);
 extern "C" void asm_start_process(int stack);
 extern "C" void asm_update_cr3(int address);
+extern "C" uint64 asm_read_tsc();
+extern "C" uint32 asm_divide(uint64 dividend, uint32 divisor);
+extern "C" void asm_page_fault_handler();
+extern "C" void asm_flush_tlb();
+extern "C" void asm_invlpg(int address);
+extern "C" int asm_read_cr3();
+extern "C" void asm_flush_tlb_global();
+extern "C" int asm_read_cr4();
+extern "C" void asm_write_cr4(int cr4);
+extern "C" void asm_memset(void *memory, int value, int length);
+extern "C" void asm_memcpy(void *dst, const void *src, int length);
+extern "C" void asm_memmove(void *dst, const void *src, int length);
+extern "C" int asm_strlen(const char *str);
+extern "C" void asm_page_zero(void *page);
+extern "C" void asm_page_copy(void *dst, const void *src);
+extern "C" void asm_read_hard_disk(void *memory, int block);
+extern "C" void asm_write_hard_disk(void *memory, int block);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "os_type.h"
+#include "sync.h"
+
+// 内核中的基准测试，由shell通过系统调用运行，结果直接输出到屏幕
+enum BenchmarkType
+{
+    BITMAP_BENCHMARK, // 位图在不同占用率下分配一个资源的耗时
+    FAULT_BENCHMARK,  // 工作集大小不同时的缺页率
+    MAPPING_BENCHMARK, // 内核虚拟页成批与逐页映射、解除映射的耗时
+    TLB_BENCHMARK,     // 通过4MB页和4KB页访问同一段物理内存的耗时
+    SWITCH_BENCHMARK,  // 两个内核线程之间切换的耗时，以及每次切换都刷新TLB的对照
+    STRING_BENCHMARK,  // 不同长度的memset、memcpy、memmove的耗时
+    LIST_BENCHMARK,    // 链表各个操作的耗时
+    DISPATCH_BENCHMARK, // 优先级混合时选择下一个就绪线程的耗时
+    FAIR_BENCHMARK,     // 公平调度在不同权重下的处理器份额和唤醒延迟
+    SPAWN_BENCHMARK     // 反复创建立即退出的进程，检查PCB是否全部归还
+};
+
+// 线程切换测试中两个线程共享的状态
+struct SwitchBenchmark
+{
+    int threads;      // 创建的线程数
+    int finished;     // 已完成的线程数
+    uint64 start;     // 第一个线程开始执行的时间
+    uint64 end;       // 最后一个线程完成的时间
+    Semaphore done;   // 两个线程都完成后释放
+    bool reload;      // 每次切换后是否重新加载CR3
+    int base;         // 每次切换后访问的4KB全局页的起始地址
+    int pages;        // 每次切换后访问的页数
+};
+
+// 公平调度测试中的线程共享的状态
+struct FairBenchmark
+{
+    int pids[4];          // 一直就绪的线程的pid
+    int ticks[4];         // 一直就绪的线程执行的时钟中断数
+    int wakeups;          // 睡眠的线程被唤醒的次数
+    int latency;          // 睡眠的线程到期后到再次执行经过的时钟中断数之和
+    int maxLatency;       // 上述时钟中断数的最大值
+    volatile bool stop;   // 测试结束，线程退出
+    int threads;          // 创建的线程数
+    int finished;         // 已退出的线程数
+    Semaphore done;       // 所有线程都退出后释放
+};
+
+// 每项测试重复的次数，输出的耗时为平均值
+#define BENCHMARK_ROUNDS 64
+// 缺页率测试时留给用户进程的空闲物理页数，其余的用户物理页被暂时占用
+#define FAULT_BENCHMARK_FRAMES 64
+// 线程切换测试中每个线程让出处理器的次数
+#define SWITCH_BENCHMARK_ROUNDS 1000
+// 线程切换测试中每次切换后访问的页数
+#define SWITCH_BENCHMARK_PAGES 32
+// 公平调度测试的时钟中断数
+#define FAIR_BENCHMARK_TICKS 1000
+// 公平调度测试中睡眠的线程每次睡眠的时钟中断数
+#define FAIR_BENCHMARK_SLEEP 50
+// 进程创建测试中创建的进程数，超过MAX_PROGRAM_AMOUNT，PCB泄漏时会耗尽
+#define SPAWN_BENCHMARK_ROUNDS 32
+
+// 运行type指定的基准测试，type不存在时返回-1
+int run_benchmark(int type);
+
+// 空闲资源散布在位图中时，next-fit、每次从头按字查找与逐位首次适配的对比
+void bitmap_benchmark();
+
+// 只留下FAULT_BENCHMARK_FRAMES个空闲的用户物理页，循环访问不同大小的工作集，统计缺页率
+void fault_benchmark();
+
+// 把1、16、256个连续的物理页映射到内核虚拟页再解除映射
+// 成批的方式按页表连续填写页表项并合并释放物理页，逐页的方式每页单独映射和释放
+// 再对比一次allocatePages、releasePages多个页与逐页调用的耗时
+void mapping_benchmark();
+
+// 一段连续的物理页既能通过直接映射区的4MB页访问，也在内核虚拟地址区中用4KB页映射
+// 每页访问一次，页数超过TLB的容量时，4KB页的每次访问都可能需要遍历页表
+void tlb_benchmark();
+
+// 两个内核线程轮流让出处理器，每次切换后访问SWITCH_BENCHMARK_PAGES个4KB的内核全局页
+// 依次测试不重新加载CR3、每次切换后重新加载CR3、关闭CR4.PGE后每次重新加载CR3，后两者为对照
+void switch_benchmark();
+
+// 8B到64KB的memset、memcpy、memmove，串操作指令的实现与逐字节的循环对比
+void string_benchmark();
+
+// 1024个元素的链表，按元素操作为O(1)，按序号操作需要遍历
+void list_benchmark();
+
+// 512个线程分布在8个优先级上，每次取出优先级最高的线程后以新的优先级放回
+// 按优先级划分的就绪队列与在单个队列中顺序查找优先级最高的线程对比，按取出的线程的优先级分别输出耗时
+void dispatch_benchmark();
+
+// 公平调度时创建4个一直就绪的内核线程，权重为1、4、7、10，运行FAIR_BENCHMARK_TICKS个时钟中断
+// 另一个线程反复睡眠FAIR_BENCHMARK_SLEEP个时钟中断，统计到期后到再次执行经过的时钟中断数
+// 启动时的调度算法不是FAIR_POLICY时跳过
+void fair_benchmark();
+
+// 用executeProcess逐个创建SPAWN_BENCHMARK_ROUNDS个立即退出的进程，这些进程没有父进程
+// 每个进程的PCB被回收线程归还后再创建下一个，比较前后已分配的PCB数
+void spawn_benchmark();
+
+#endif
@@ -8,8 +8,10 @@ class BitMap
 public:
     // 被管理的资源个数，bitmap的总位数
     int length;
-    // bitmap的起始地址
+    // bitmap的起始地址，按32位字访问，需4字节对齐
     char *bitmap;
+    // 下次分配时开始查找的位置(next-fit)
+    int hint;
 public:
     // 初始化
     BitMap();
@@ -23,11 +25,23 @@ public:
     int allocate(const int count);
     // 释放第index个资源开始的count个资源
     void release(const int index, const int count);
+    // 将第index个资源开始的count个资源标记为已分配
+    void reserve(const int index, const int count);
     // 返回Bitmap存储区域
     char *getBitmap();
     // 返回Bitmap的大小
     int size() const;
+    // 统计未分配的资源数free和最长的一段连续未分配资源数largest
+    void countFree(int &free, int &largest) const;
 private:
+    // 返回[index, limit)中第一个未分配资源的序号，没有则返回limit
+    int findFree(int index, const int limit) const;
+    // 返回[index, limit)中第一个已分配资源的序号，没有则返回limit
+    int findUsed(int index, const int limit) const;
+    // 在[from, to)中查找连续count个未分配的资源
+    int search(const int from, const int to, const int count) const;
+    // 将第index个资源开始的count个资源设置为status，整字处理
+    void setRange(const int index, const int count, const bool status);
     // 禁止Bitmap之间的赋值
     BitMap(const BitMap &) {}
     void operator=(const BitMap&) {}
@@ -0,0 +1,29 @@
+#ifndef BOOT_INFO_H
+#define BOOT_INFO_H
+
+#include "os_type.h"
+
+// E820h返回的可用内存区域的类型
+#define E820_USABLE 1
+// 最多记录的内存区域数，与boot.inc中的定义相同
+#define E820_MAX_ENTRIES 32
+
+// INT 15h, E820h返回的一个内存区域
+struct E820Entry
+{
+    uint32 baseLow;    // 起始地址的低32位
+    uint32 baseHigh;   // 起始地址的高32位
+    uint32 lengthLow;  // 长度的低32位
+    uint32 lengthHigh; // 长度的高32位
+    uint32 type;       // 区域类型
+};
+
+// mbr收集的启动信息，存放在BOOT_INFO_ADDRESS
+struct BootInfo
+{
+    // 内存区域数，为0表示BIOS不支持E820h
+    uint32 e820Count;
+    E820Entry e820[E820_MAX_ENTRIES];
+};
+
+#endif
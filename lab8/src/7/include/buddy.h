@@ -0,0 +1,66 @@
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include "os_type.h"
+
+// 伙伴系统的最大阶，最大的块包含2^BUDDY_MAX_ORDER个页
+#define BUDDY_MAX_ORDER 10
+
+struct BuddyPage
+{
+    int previous; // 空闲链表中的前一个块，-1表示没有
+    int next;     // 空闲链表中的后一个块，-1表示没有
+    char order;   // 空闲块的阶，仅对空闲块的第一个页有效
+    bool free;    // 是否为空闲块的第一个页
+};
+
+class BuddyAllocator
+{
+public:
+    // 被管理的页数
+    int length;
+    // 第一个页的起始地址
+    int startAddress;
+    // 每个页的信息
+    BuddyPage *pages;
+    // 第order阶空闲链表的表头，-1表示链表为空
+    int freeList[BUDDY_MAX_ORDER + 1];
+    // 第order阶空闲块的数量
+    int freeBlocks[BUDDY_MAX_ORDER + 1];
+    // 分配成功的次数
+    int allocations;
+    // 分配失败的次数
+    int failures;
+    // 释放的次数
+    int releases;
+
+public:
+    BuddyAllocator();
+    // 初始化伙伴系统，metadata=页信息的存放地址，初始化后所有的页均处于已分配状态
+    void initialize(char *metadata, const int length, const int startAddress);
+    // 分配count个连续页，成功则返回第一个页的地址，失败则返回-1
+    int allocate(const int count);
+    // 释放从address开始的amount个页
+    void release(const int address, const int amount);
+    // 返回第order阶空闲块包含的页数
+    int getFreePages(const int order) const;
+    // 统计空闲页数free和最大的空闲块包含的页数largest
+    void countFree(int &free, int &largest) const;
+    // 返回管理length个页需要的页信息的字节数
+    static int metadataSize(const int length);
+
+private:
+    // 将第index个页开始的order阶块放入空闲链表
+    void pushFree(const int index, const int order);
+    // 将第index个页开始的块从空闲链表中删除
+    void removeFree(const int index);
+    // 释放第index个页开始的order阶块，并与空闲的伙伴合并
+    void releaseBlock(int index, int order);
+    // 释放第index个页开始的count个页
+    void releaseRange(int index, int count);
+    // 禁止BuddyAllocator之间的赋值
+    BuddyAllocator(const BuddyAllocator &) {}
+    void operator=(const BuddyAllocator &) {}
+};
+
+#endif
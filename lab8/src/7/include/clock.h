@@ -0,0 +1,47 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "os_type.h"
+
+// 单调时钟的读数
+struct TimeSpec
+{
+    uint32 seconds;     // 秒
+    uint32 nanoseconds; // 不足一秒的纳秒数，[0, 1000000000)
+};
+
+// 8253产生频率为HZ的时钟中断，时钟中断之间的时间由时间戳计数器插值
+// 单调时钟在每次时钟中断时以时间戳计数器的增量推进，不受时钟中断被推迟的影响
+class Clock
+{
+public:
+    // 8253计数器0的初值
+    uint32 divisor;
+    // 每个时钟中断的纳秒数
+    uint32 nsPerTick;
+    // 校准得到的每个时钟中断的时间戳计数器增量，为0表示没有可用的时间戳计数器
+    uint32 cyclesPerTick;
+    // 时间戳计数器增量换算为纳秒的乘数，纳秒数 = 增量 * mult >> CLOCK_SHIFT
+    uint32 mult;
+    // 最近一次推进时的时间戳计数器
+    uint64 lastCycles;
+    // 最近一次推进时的单调时钟，单位为纳秒
+    uint64 lastNanoseconds;
+
+public:
+    Clock();
+    // 将8253设置为每秒产生hz次时钟中断，并用8253校准时间戳计数器，需要在关中断时调用
+    void initialize(uint32 hz);
+    // 时钟中断处理函数调用，推进单调时钟
+    void tick();
+    // 启动后经过的纳秒数
+    uint64 now();
+    // 将启动后经过的时间写入time
+    void getTime(TimeSpec &time);
+
+private:
+    // 用8253的计数器2计时TSC_CALIBRATE_COUNT个时钟周期，返回时间戳计数器的增量
+    uint32 calibrate();
+};
+
+#endif
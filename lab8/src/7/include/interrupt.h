@@ -3,6 +3,9 @@
 
 #include "os_type.h"
 
+// 启动后的时钟中断数
+extern uint32 jiffies;
+
 class InterruptManager
 {
 private:
@@ -7,10 +7,22 @@ struct ListItem
     ListItem *next;
 };
 
+// 由结构体T中的成员member的地址item得到T的地址，item为nullptr时返回nullptr
+template <typename T>
+T *container_of(ListItem *item, ListItem T::*member)
+{
+    return item ? (T *)((int)item - (int)&(((T *)0)->*member)) : nullptr;
+}
+
+// 带哨兵的循环双向链表，head.next为第一个元素，head.previous为最后一个元素
+// 除按序号访问的操作外，均为O(1)
 class List
 {
 public:
+    // 哨兵，List为空时指向自身
     ListItem head;
+    // 元素个数
+    int length;
 
 public:
     // 初始化List
@@ -39,11 +51,34 @@ public:
     void insert(int pos, ListItem *itemPtr);
     // 删除pos位置处的元素
     void erase(int pos);
+    // 删除元素itemPtr，itemPtr必须在List中
     void erase(ListItem *itemPtr);
     // 返回指向pos位置处的元素的指针
     ListItem *at(int pos);
     // 返回给定元素在List中的序号
     int find(ListItem *itemPtr);
+    // 返回itemPtr的下一个元素，itemPtr是最后一个元素时返回nullptr
+    ListItem *next(ListItem *itemPtr);
+
+    // 按顺序遍历元素所在的结构体，member为结构体中的ListItem成员
+    // for (PCB *p = list.first(&PCB::tagInAllList); p; p = list.next(p, &PCB::tagInAllList))
+    template <typename T>
+    T *first(ListItem T::*member)
+    {
+        return container_of(front(), member);
+    }
+
+    template <typename T>
+    T *next(T *object, ListItem T::*member)
+    {
+        return container_of(next(&(object->*member)), member);
+    }
+
+private:
+    // 将itemPtr插入到previous之后
+    void link(ListItem *previous, ListItem *itemPtr);
+    // 将itemPtr从List中取下
+    void unlink(ListItem *itemPtr);
 };
 
-#endif
\ No newline at end of file
+#endif
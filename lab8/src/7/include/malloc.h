@@ -0,0 +1,32 @@
+#ifndef MALLOC_H
+#define MALLOC_H
+
+// 用户态内存分配器，管理信息存放在用户进程堆的开头，仅供用户进程使用
+
+// 小块内存的大小类别为16B, 32B, ..., 2048B
+#define MALLOC_CLASS_AMOUNT 8
+#define MALLOC_MIN_SIZE 16
+#define MALLOC_MAX_SIZE 2048
+// 堆空间不足时每次至少扩展的字节数
+#define MALLOC_GROW_SIZE (16 * 4096)
+
+struct MallocBlock
+{
+    int size;          // 可用的字节数，不含头部
+    MallocBlock *next; // 空闲链表中的下一个块，仅在空闲时有效
+};
+
+struct MallocArena
+{
+    char *top;                                  // 堆中尚未划分的区域的起始地址
+    char *end;                                  // 堆的结束地址
+    MallocBlock *freeList[MALLOC_CLASS_AMOUNT]; // 各大小类别的空闲链表
+    MallocBlock *largeList;                     // 大块内存的空闲链表，按地址排序，相邻的块已合并
+};
+
+// 分配size个字节，失败返回nullptr
+void *malloc(int size);
+// 释放malloc分配的内存
+void free(void *address);
+
+#endif
@@ -2,6 +2,21 @@
 #define MEMORY_H
 
 #include "address_pool.h"
+#include "buddy.h"
+#include "os_constant.h"
+#include "sync.h"
+#include "slab.h"
+
+// 直接映射区中物理地址与内核虚拟地址的转换
+inline int phys2virt(const int paddr)
+{
+    return paddr + KERNEL_DIRECT_MAP_START;
+}
+
+inline int virt2phys(const int vaddr)
+{
+    return vaddr - KERNEL_DIRECT_MAP_START;
+}
 
 enum AddressPoolType
 {
@@ -9,46 +24,226 @@ enum AddressPoolType
     KERNEL
 };
 
+struct PCB;
+
+// 用户物理页的反向映射
+struct FrameMapping
+{
+    PCB *owner; // 映射该物理页的进程，nullptr表示该页不能被换出
+    int vaddr;  // 该物理页在进程中的虚拟地址
+};
+
+// 延迟的TLB刷新，修改一批页表项后一起刷新
+class TLBFlushBatch
+{
+public:
+    // 等待刷新的虚拟页
+    int pages[TLB_FLUSH_THRESHOLD];
+    // 等待刷新的虚拟页数，超过TLB_FLUSH_THRESHOLD时只记录数量
+    int count;
+    // 是否包含内核空间的全局页
+    bool global;
+
+public:
+    TLBFlushBatch();
+    // 记录vaddr所在的页需要刷新
+    void add(const int vaddr);
+    // 使记录的页的TLB项失效，页数超过TLB_FLUSH_THRESHOLD时刷新整个TLB
+    // 包含全局页时，重新加载CR3不能使其失效，需要同时刷新全局页
+    void flush();
+};
+
+// 可用的物理内存区域[start, end)，按页对齐
+struct MemoryRange
+{
+    uint32 start;
+    uint32 end;
+};
+
+// 操作耗时的直方图，按时钟周期数的对数分桶
+class LatencyHistogram
+{
+public:
+    // 第i个桶记录耗时在[2^i, 2^(i+1))个时钟周期内的操作数，最后一个桶包括更长的操作
+    uint32 buckets[LATENCY_BUCKETS];
+    // 记录的操作数
+    uint32 count;
+    // 最长的耗时，超过32位时记为0xffffffff
+    uint32 maximum;
+
+public:
+    LatencyHistogram();
+    void initialize();
+    // 记录一次耗时cycles个时钟周期的操作
+    void record(const uint64 cycles);
+};
+
+// 地址池的统计信息
+struct PoolStatistics
+{
+    int totalPages;     // 管理的页数，包括空洞
+    int freePages;      // 空闲页数
+    int largestFree;    // 最长的一段连续空闲页的页数
+    int fragmentation;  // 碎片化指数，0表示空闲页全部连续，越接近100空闲页越分散
+    int allocations;    // 分配成功的次数
+    int failures;       // 分配失败的次数
+    int releases;       // 释放的次数
+};
+
+// 预先清零的页的池的统计信息
+struct ZeroPoolStatistics
+{
+    int pages;   // 池中的页数
+    int hits;    // 从池中取得已清零的页的次数
+    int misses;  // 池为空的次数
+    int refills; // 后台补充的页数
+};
+
+// 内存管理器的统计信息
+struct MemoryStatistics
+{
+    PoolStatistics kernelPhysical;
+    PoolStatistics userPhysical;
+    PoolStatistics kernelVirtual;
+    ZeroPoolStatistics kernelZero;
+    ZeroPoolStatistics userZero;
+    // allocatePages的耗时
+    LatencyHistogram allocateLatency;
+    // releasePages的耗时
+    LatencyHistogram releaseLatency;
+    // 累计换出的页数
+    int swapOuts;
+    // 累计换入的页数
+    int swapIns;
+    // 各个slab cache的使用情况
+    SlabStatistics caches[MAX_SLAB_CACHES];
+    // caches中有效的项数
+    int cacheAmount;
+};
+
+// 物理地址池的分配算法
+enum PhysicalPoolBackend
+{
+    BITMAP_BACKEND, // 位图，首次适配
+    BUDDY_BACKEND   // 伙伴系统
+};
+
+// 预先清零的物理页，由后台线程在池中的页被取走后补充
+class ZeroPagePool
+{
+public:
+    // 已清零的物理页，按栈的方式存取
+    int frames[ZERO_POOL_PAGES];
+    // 池中的页数
+    int count;
+    // 物理页所属的物理地址池
+    enum AddressPoolType type;
+    // 从池中取得已清零的页的次数
+    int hits;
+    // 池为空，分配时才清零的次数
+    int misses;
+    // 后台补充的页数
+    int refills;
+
+public:
+    ZeroPagePool();
+    void initialize(enum AddressPoolType type);
+    // 取出一个已清零的物理页，池为空时返回0
+    int allocate();
+    // 池未满时分配一个物理页，清零后放入池中
+    // 补充了一页，返回true；池已满或无法分配物理页，返回false
+    bool refill();
+};
+
 class MemoryManager
 {
 public:
-    // 可管理的内存容量
+    // 可用的物理内存容量
     int totalMemory;
     // 内核物理地址池
     AddressPool kernelPhysical;
     // 用户物理地址池
     AddressPool userPhysical;
-    // 内核虚拟地址池
+    // 内核虚拟地址区的地址池，用于映射不连续的物理页
     AddressPool kernelVirtual;
+    // 物理地址池使用的分配算法
+    enum PhysicalPoolBackend backend;
+    // 内核物理地址池的伙伴系统
+    BuddyAllocator kernelBuddy;
+    // 用户物理地址池的伙伴系统
+    BuddyAllocator userBuddy;
+    // 用户物理页的引用计数，写时复制的页被多个进程共享
+    uint8 *userFrameReferences;
+    // 用户物理页的反向映射，换出页时用于找到页表项
+    FrameMapping *userFrameMappings;
+    // 预先清零的内核物理页
+    ZeroPagePool kernelZeroPages;
+    // 预先清零的用户物理页
+    ZeroPagePool userZeroPages;
+    // 后台清零线程无页可补充时在此等待，池中的页数低于低水位时被唤醒
+    Semaphore zeroPageDemand;
+    // 后台清零线程是否在zeroPageDemand上等待
+    bool zeroThreadWaiting;
+    // allocatePages的耗时
+    LatencyHistogram allocateLatency;
+    // releasePages的耗时
+    LatencyHistogram releaseLatency;
 
 public:
     MemoryManager();
 
-    // 初始化地址池
-    void initialize();
+    // 初始化地址池，backend指定物理地址池的分配算法
+    void initialize(enum PhysicalPoolBackend backend = PhysicalPoolBackend::BITMAP_BACKEND);
+
+    // 使用pool中空闲的页初始化伙伴系统，metadata为页信息的存放地址
+    void initializeBuddy(BuddyAllocator &buddy, AddressPool &pool, const int metadata);
 
     // 从type类型的物理地址池中分配count个连续的页
+    // reclaim为true时，物理页耗尽后会使用预先清零的页，用户物理页还会换出页
     // 成功，返回起始地址；失败，返回0
-    int allocatePhysicalPages(enum AddressPoolType type, const int count);
+    int allocatePhysicalPages(enum AddressPoolType type, const int count, const bool reclaim = true);
 
-    // 释放从paddr开始的count个物理页
-    void releasePhysicalPages(enum AddressPoolType type, const int startAddress, const int count);
+    // 分配一个清零的物理页，优先从预先清零的页中取得
+    // 成功，返回物理地址；失败，返回0
+    int allocateZeroedPage(enum AddressPoolType type);
+
+    // 将物理页paddr清零
+    void zeroPhysicalPage(const int paddr);
+
+    // 释放从paddr开始的count个物理页，owner为释放用户物理页的进程，nullptr表示当前进程
+    void releasePhysicalPages(enum AddressPoolType type, const int startAddress, const int count, PCB *owner = nullptr);
 
     // 获取内存总容量
     int getTotalMemory();
 
+    // 从E820h返回的内存布局中找出可用的区域，不支持E820h时使用E801h的结果
+    // 区域按地址排序且互不重叠，返回区域数
+    // 超出直接映射区而不被管理的可用内存的MB数写入ignored
+    int getUsableMemory(MemoryRange *ranges, int &ignored);
+
+    // 将pool管理的地址中不属于ranges的空洞标记为已分配，返回空洞的页数
+    int reserveHoles(AddressPool &pool, const MemoryRange *ranges, const int count);
+
     // 开启分页机制
     void openPageMechanism();
 
-    // 页内存分配
+    // 页内存分配，用户页只分配虚拟页，物理页在首次访问时分配
+    // 内核页优先分配连续的物理页并返回其在直接映射区中的地址，失败时在内核虚拟地址区中逐页映射
     int allocatePages(enum AddressPoolType type, const int count);
 
+    // allocatePages的实现，不记录耗时
+    int doAllocatePages(enum AddressPoolType type, const int count);
+
     // 虚拟页分配
     int allocateVirtualPages(enum AddressPoolType type, const int count);
 
     // 建立虚拟页到物理页的联系
     bool connectPhysicalVirtualPage(const int virtualAddress, const int physicalPageAddress);
 
+    // 将从virtualAddress开始的count个虚拟页依次映射到从physicalAddress开始的连续物理页
+    // 返回成功映射的页数，无法分配页表时小于count
+    int connectPhysicalVirtualPages(const int virtualAddress, const int physicalAddress, const int count);
+
     // 计算virtualAddress的页目录项的虚拟地址
     int toPDE(const int virtualAddress);
 
@@ -58,11 +253,52 @@ public:
     // 页内存释放
     void releasePages(enum AddressPoolType type, const int virtualAddress, const int count);    
 
-    // 找到虚拟地址对应的物理地址
+    // releasePages的实现，不记录耗时
+    void doReleasePages(enum AddressPoolType type, const int virtualAddress, const int count);
+
+    // 获取各地址池的统计信息和页分配、释放的耗时
+    void getStatistics(MemoryStatistics &statistics);
+
+    // 获取预先清零的页的池pool的统计信息
+    void getZeroPoolStatistics(ZeroPoolStatistics &statistics, ZeroPagePool &pool);
+
+    // 获取地址池pool的统计信息，buddy不为nullptr时空闲页和分配次数由伙伴系统统计
+    void getPoolStatistics(PoolStatistics &statistics, AddressPool &pool, BuddyAllocator *buddy);
+
+    // 释放从virtualAddress开始的count个虚拟页对应的物理页并清除页表项，虚拟页保持分配
+    void unmapPages(enum AddressPoolType type, const int virtualAddress, const int count);
+
+    // 找到虚拟地址对应的物理地址，直接映射区内的地址直接计算，其余的查找页表
     int vaddr2paddr(int vaddr);
 
+    // vaddr是否位于内核的直接映射区
+    bool isDirectMapped(const int vaddr);
+
     // 释放虚拟页
     void releaseVirtualPages(enum AddressPoolType type, const int vaddr, const int count);
+
+    // 增加用户物理页paddr的引用计数
+    void addFrameReference(const int paddr);
+
+    // 返回用户物理页paddr的引用计数
+    int getFrameReference(const int paddr);
+
+    // 记录用户物理页paddr被进程owner映射到虚拟地址vaddr
+    void setFrameMapping(const int paddr, PCB *owner, const int vaddr);
+
+    // 使vaddr所在页的TLB项失效
+    void invalidatePage(const int vaddr);
+
+    // 处理对写时复制的页的写操作，address为引起缺页的虚拟地址
+    // 成功，返回true；address不是写时复制的页或无法分配物理页，返回false
+    bool copyOnWrite(const int address);
+
+    // 为首次访问的已分配用户虚拟页分配清零的物理页，address为引起缺页的虚拟地址
+    // 成功，返回true；address不属于已分配的用户虚拟页或无法分配物理页，返回false
+    bool allocateOnDemand(const int address);
 };
 
+// 后台清零线程
+void zero_page_thread(void *arg);
+
 #endif
\ No newline at end of file
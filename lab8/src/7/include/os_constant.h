@@ -7,13 +7,75 @@
 
 #define MAX_PROGRAM_NAME 16
 #define MAX_PROGRAM_AMOUNT 16
+// 时钟中断的频率，8253的计数器初值为PIT_FREQUENCY / HZ，HZ不能小于19
+#define HZ 100
+// 8253的输入时钟频率
+#define PIT_FREQUENCY 1193182
+// 校准时间戳计数器的时长，单位为8253的时钟周期，不超过65535
+#define TSC_CALIBRATE_COUNT 59659
+// 时间戳计数器增量换算为纳秒时乘数的小数位数
+#define CLOCK_SHIFT 24
+
+// 时间轮的层数和每层的槽数的位数，可以表示的最长定时为2^(TIMER_LEVELS * TIMER_SLOT_BITS)个时钟中断
+#define TIMER_LEVELS 4
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+
+// 线程优先级的级数，优先级的范围为[0, PRIORITY_LEVELS)，不超过32
+#define PRIORITY_LEVELS 32
+// 最低的优先级，后台线程只在没有其他就绪线程时执行
+#define LOWEST_PRIORITY 0
+// 公平调度中，优先级为p的线程每个时钟中断增加FAIR_WEIGHT_SCALE / (p + 1)的虚拟运行时间
+#define FAIR_WEIGHT_SCALE 1024
+// 公平调度的时间片，单位为时钟中断
+#define FAIR_TIME_SLICE 10
+// 被唤醒的线程的虚拟运行时间至多比最小值少半个时间片，既能尽快执行，又不能独占处理器
+#define FAIR_WAKEUP_CREDIT (FAIR_WEIGHT_SCALE * FAIR_TIME_SLICE / 2)
 
 #define MEMORY_SIZE_ADDRESS 0xc0007c00
 #define PAGE_SIZE 4096
-#define BITMAP_START_ADDRESS 0xc0010000
+// mbr收集的启动信息，位于IDT之后
+#define BOOT_INFO_ADDRESS 0xc0009100
+// 只管理直接映射区能够覆盖的物理内存，任何物理页都可以通过直接映射区访问
+#define MAX_PHYSICAL_ADDRESS (KERNEL_VIRTUAL_START - KERNEL_DIRECT_MAP_START)
 
 #define PAGE_DIRECTORY 0x100000
-#define KERNEL_VIRTUAL_START 0xc0100000
+// 页表项的G位，内核空间的页是全局页，重新加载CR3时不被刷新
+#define PAGE_GLOBAL 0x100
+// 页表项的可用位，标记写时复制的页
+#define PAGE_COW 0x200
+// 页表项的可用位，P=0时标记已换出到交换区的页，页槽号存放在12~31位
+#define PAGE_SWAPPED 0x400
+
+// 页表项的可用位，标记映射共享内存段的页，fork时不做写时复制
+#define PAGE_SHARED 0x800
+
+// 共享内存段的最大数量和每个段的最大页数
+#define MAX_SHARED_SEGMENTS 16
+#define MAX_SHARED_PAGES 1024
+
+// 交换区在硬盘上的起始扇区和页槽数
+#define SWAP_START_SECTOR 2048
+#define SWAP_PAGES 1024
+#define SECTOR_SIZE 512
+
+// 每个物理地址池预先清零的页数
+#define ZERO_POOL_PAGES 64
+// 池中的页数低于该值时唤醒后台清零线程
+#define ZERO_POOL_LOW_WATER 32
+
+// 延迟直方图的桶数，第i个桶统计耗时在[2^i, 2^(i+1))个时钟周期内的操作
+#define LATENCY_BUCKETS 24
+
+// 一次延迟刷新的TLB项超过该数量时，改为刷新整个TLB
+#define TLB_FLUSH_THRESHOLD 32
+// 内核空间从3GB开始直接映射物理内存，虚拟地址 = 物理地址 + KERNEL_DIRECT_MAP_START
+#define KERNEL_DIRECT_MAP_START 0xc0000000
+// 直接映射使用的4MB大页
+#define LARGE_PAGE_SIZE 0x400000
+// 内核虚拟地址区，由4KB的页映射到不连续的物理页，占用倒数第二个页目录项
+#define KERNEL_VIRTUAL_START 0xff800000
+#define KERNEL_VIRTUAL_PAGES 1024
 
 #define MAX_SYSTEM_CALL 256
 
@@ -28,4 +90,8 @@
 
 #define USER_VADDR_START 0x8048000
 
+// 用户进程的堆，在用户虚拟地址池中预留
+#define USER_HEAP_START 0x40000000
+#define USER_HEAP_PAGES 16384
+
 #endif
\ No newline at end of file
@@ -7,6 +7,12 @@
 #include "memory.h"
 #include "syscall.h"
 #include "tss.h"
+#include "slab.h"
+#include "swap.h"
+#include "shm.h"
+#include "clock.h"
+#include "timer.h"
+#include "vma.h"
 
 extern InterruptManager interruptManager;
 extern STDIO stdio;
@@ -14,5 +20,11 @@ extern ProgramManager programManager;
 extern MemoryManager memoryManager;
 extern SystemService systemService;
 extern TSS tss;
+extern SlabAllocator slabAllocator;
+extern SwapManager swapManager;
+extern SharedMemoryManager sharedMemoryManager;
+extern Clock systemClock;
+extern TimerManager timerManager;
+extern ObjectCache<VirtualArea> virtualAreaCache;
 
 #endif
\ No newline at end of file
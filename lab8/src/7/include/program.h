@@ -3,50 +3,125 @@
 
 #include "list.h"
 #include "thread.h"
+#include "sync.h"
+#include "run_queue.h"
 
-#define ListItem2PCB(ADDRESS, LIST_ITEM) ((PCB *)((int)(ADDRESS) - (int)&((PCB *)0)->LIST_ITEM))
+// 处理器的使用情况，单位为时钟中断
+struct CPUStatistics
+{
+    int totalTicks; // 启动后经过的时钟中断数
+    int idleTicks;  // 其中空闲线程执行的时钟中断数
+    int reaperQueueDepth;    // 等待回收地址空间的进程数
+    int maxReaperQueueDepth; // 等待回收的进程数曾经达到的最大值
+    int reapedPrograms;      // 已回收的进程数
+    int reapedFrames;        // 回收的物理页数
+    int reapTicks;           // 回收线程执行回收花费的时钟中断数
+};
+
+// 进程的内存使用情况
+struct ProcessStatistics
+{
+    int pid;                         // 进程pid
+    char name[MAX_PROGRAM_NAME + 1]; // 进程名
+    enum ProgramStatus status;       // 进程的状态
+    int lazyPages;                   // 延迟分配物理页的虚拟页数
+    int demandFaults;                // 首次访问时分配物理页的缺页次数
+    int cowFaults;                   // 写时复制的缺页次数
+    int swapFaults;                  // 从交换区换入页的缺页次数
+};
+
+// 线程调度算法
+enum SchedulingPolicy
+{
+    ROUND_ROBIN_POLICY, // 按优先级的时间片轮转，优先级越高时间片越长，高优先级的就绪线程先执行
+    FAIR_POLICY         // 公平调度，按优先级加权的虚拟运行时间分配处理器
+};
 
 class ProgramManager
 {
 public:
     List allPrograms;        // 所有状态的线程/进程的队列
-    List readyPrograms;      // 处于ready(就绪态)的线程/进程的队列
+    PriorityRunQueue readyPrograms; // 处于ready(就绪态)的线程/进程的队列，按优先级划分
+    FairRunQueue fairPrograms; // 公平调度时处于ready(就绪态)的线程/进程，按虚拟运行时间排序
+    enum SchedulingPolicy policy; // 线程调度算法
     PCB *running;            // 当前执行的线程
+    PCB *idle;               // 空闲线程，不在就绪队列中，没有就绪线程时执行
+    int idleTicks;           // 空闲线程执行的时钟中断数
     int USER_CODE_SELECTOR;  // 用户代码段选择子
     int USER_DATA_SELECTOR;  // 用户数据段选择子
     int USER_STACK_SELECTOR; // 用户栈段选择子
+    List reaperQueue;        // 等待回收地址空间的已退出进程的队列
+    Semaphore reaperSemaphore; // reaperQueue中的进程数
+    int reaperQueueDepth;    // reaperQueue中的进程数
+    int maxReaperQueueDepth; // reaperQueue中曾经达到的最大进程数
+    int reapedPrograms;      // 已回收的进程数
+    int reapedFrames;        // 回收的物理页数，不包括仍被其他进程共享的页
+    int reapTicks;           // 回收线程执行回收花费的时钟中断数
 public:
     ProgramManager();
-    void initialize();
+    // policy指定线程调度算法
+    void initialize(enum SchedulingPolicy policy = SchedulingPolicy::ROUND_ROBIN_POLICY);
 
     // 创建一个线程并放入就绪队列
 
     // function：线程执行的函数
     // parameter：指向函数的参数的指针
     // name：线程的名称
-    // priority：线程的优先级
+    // priority：线程的优先级，超出[0, PRIORITY_LEVELS)时取最接近的值
 
     // 成功，返回pid；失败，返回-1
     int executeThread(ThreadFunction function, void *parameter, const char *name, int priority);
 
+    // 创建一个线程，但不放入任何队列
+    // 成功，返回线程的PCB；失败，返回nullptr
+    PCB *createThread(ThreadFunction function, void *parameter, const char *name, int priority);
+
     // 分配一个PCB
     PCB *allocatePCB();
     // 归还一个PCB
     // program：待释放的PCB
     void releasePCB(PCB *program);
+    // 返回已分配的PCB数
+    int countPCB();
 
     // 执行线程调度
     void schedule();
 
+    // 将program放入所用调度算法的就绪队列
+    // 新创建的线程created=true，被唤醒的线程wakeup=true，公平调度据此调整其虚拟运行时间
+    void addReady(PCB *program, const bool created, const bool wakeup);
+
+    // 取出下一个执行的线程，若没有就绪线程，则返回nullptr
+    PCB *takeReady();
+
+    // 返回是否有就绪线程
+    bool hasReady();
+
+    // 返回program的时间片，单位为时钟中断
+    int timeSlice(PCB *program);
+
+    // 当前线程program执行了一个时钟中断
+    void charge(PCB *program);
+
+    // 获取处理器的使用情况
+    void getStatistics(CPUStatistics &statistics);
+
+    // 将至多max个用户进程的内存使用情况写入statistics，返回写入的数量
+    int getProcessStatistics(ProcessStatistics *statistics, const int max);
+
     // 阻塞唤醒
     void MESA_WakeUp(PCB *program);
 
     // 初始化TSS
     void initializeTSS();
 
-    // 创建线程
+    // 创建一个进程并放入就绪队列
     int executeProcess(const char *filename, int priority);
 
+    // 创建一个进程的PCB、页目录表和虚拟地址池，但不放入任何队列
+    // 成功，返回进程的PCB；失败，返回nullptr
+    PCB *createProcess(const char *filename, int priority);
+
     // 创建用户页目录表
     int createProcessPageDirectory();
 
@@ -59,18 +134,35 @@ public:
     // 创建子进程
     int fork();
 
-    // 复制进程
+    // 复制进程，失败时撤销已复制的页表
     bool copyProcess(PCB *parent, PCB *child);
 
-    // 进程退出
+    // 释放copyProcess为child复制的前end个页目录项的页表，撤销对其中的物理页和页槽的引用
+    void releaseCopiedPageTables(PCB *child, const int end);
+
+    // 进程退出，地址空间交给回收线程释放
     void exit(int ret);
 
+    // 将已退出或创建失败的进程program交给回收线程
+    void queueReap(PCB *program);
+
+    // 释放已退出进程program的地址空间和PCB
+    void reap(PCB *program);
+
     // 等待子进程
     int wait(int *retval);
 
+    // 将用户进程堆的结束地址增加increment个字节
+    // 成功，返回原来的结束地址；失败，返回-1
+    int sbrk(int increment);
+
 };
 
 void program_exit();
 void load_process(const char *filename);
+// 回收线程，依次释放已退出进程的地址空间
+void reaper_thread(void *arg);
+// 空闲线程，开中断后停机，直到有线程就绪
+void idle_thread(void *arg);
 
 #endif
\ No newline at end of file
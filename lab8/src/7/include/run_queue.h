@@ -0,0 +1,93 @@
+#ifndef RUN_QUEUE_H
+#define RUN_QUEUE_H
+
+#include "list.h"
+#include "os_type.h"
+#include "os_constant.h"
+#include "thread.h"
+
+// 按优先级划分的就绪队列，每个优先级一个FIFO队列，优先级数值越大越优先
+// 位图记录非空的队列，选择下一个线程时只需找到位图中最高的1
+class PriorityRunQueue
+{
+public:
+    // 第i个队列存放优先级为i的就绪线程
+    List queues[PRIORITY_LEVELS];
+    // 第i位为1表示第i个队列非空
+    uint32 bitmap;
+    // 就绪线程的总数
+    int length;
+
+public:
+    PriorityRunQueue();
+    void initialize();
+    // 返回就绪线程的总数
+    int size();
+    // 返回是否没有就绪线程
+    bool empty();
+    // 将program加入到其优先级的队列的结尾
+    void push_back(PCB *program);
+    // 将program加入到其优先级的队列的头部
+    void push_front(PCB *program);
+    // 返回优先级最高的非空队列的第一个线程，若没有，则返回nullptr
+    PCB *front();
+    // 删除front()返回的线程
+    void pop_front();
+
+private:
+    // 返回优先级最高的非空队列的序号，位图必须非空
+    int highest();
+};
+
+// 公平调度的就绪队列，就绪线程按虚拟运行时间组成AVL树，每次选择虚拟运行时间最小的线程
+// 优先级越高，虚拟运行时间增长越慢，得到的处理器时间越多
+class FairRunQueue
+{
+public:
+    PCB *root;
+    // 虚拟运行时间最小的就绪线程
+    PCB *leftmost;
+    // 就绪线程的总数
+    int length;
+    // 就绪线程和当前线程的虚拟运行时间的最小值，单调不减，新的和被唤醒的线程以此为基准
+    uint32 minVruntime;
+    // 下一个插入的线程的序号
+    uint32 order;
+
+public:
+    FairRunQueue();
+    void initialize();
+    // 返回就绪线程的总数
+    int size();
+    // 返回是否没有就绪线程
+    bool empty();
+    // 按program当前的虚拟运行时间插入
+    void push(PCB *program);
+    // 调整新创建(wakeup=false)或被唤醒(wakeup=true)的线程的虚拟运行时间后插入
+    void place(PCB *program, const bool wakeup);
+    // 返回虚拟运行时间最小的线程，若没有，则返回nullptr
+    PCB *front();
+    // 删除front()返回的线程
+    void pop_front();
+    // 当前线程program执行了一个时钟中断，累计其虚拟运行时间
+    void charge(PCB *program);
+
+private:
+    // 虚拟运行时间可能回绕，按差值的符号比较
+    bool before(const uint32 a, const uint32 b);
+    // a是否应当先于b执行
+    bool less(PCB *a, PCB *b);
+    // 使minVruntime不小于current和leftmost中较小的虚拟运行时间
+    void updateMinimum(PCB *current);
+    // 在以node为根的子树中插入program，返回新的根
+    PCB *insertNode(PCB *node, PCB *program);
+    // 删除以node为根的子树中最先执行的线程，返回新的根
+    PCB *removeFirst(PCB *node);
+    // 重新计算node的高度，必要时旋转，返回新的根
+    PCB *balance(PCB *node);
+    PCB *rotateLeft(PCB *node);
+    PCB *rotateRight(PCB *node);
+    int height(PCB *node);
+};
+
+#endif
@@ -1,14 +1,34 @@
 #ifndef SHELL_H
 #define SHELL_H
 
+#include "memory.h"
+
 class Shell
 {
 public:
     Shell();
     void initialize();
     void run();
+    // 命令bench，运行基准测试
+    void benchmark();
+    // 命令meminfo，输出内存管理器的统计信息
+    void memoryInfo();
+    // 命令cpuinfo，输出处理器的使用情况
+    void cpuInfo();
+    // 命令ps，输出用户进程的内存使用情况
+    void processInfo();
 private:
     void printLogo();
+    // 用户态malloc的分割、合并检查和吞吐量
+    void mallocBenchmark();
+    // 父子进程轮流让出处理器，每次切换都切换地址空间
+    void switchBenchmark();
+    // 通过共享内存与通过write系统调用传递消息的耗时
+    void sharedMemoryBenchmark();
+    void printPool(const char *name, const PoolStatistics &pool);
+    void printZeroPool(const char *name, const ZeroPoolStatistics &pool);
+    void printLatency(const char *name, const LatencyHistogram &latency);
+    void printCache(const SlabStatistics &cache);
 };
 
 #endif
\ No newline at end of file
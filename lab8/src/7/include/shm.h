@@ -0,0 +1,48 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include "os_type.h"
+#include "os_constant.h"
+
+// 共享内存段，同一组物理页被映射到多个进程的用户地址空间
+struct SharedSegment
+{
+    int pages;     // 页数，0表示该段未使用
+    int *frames;   // 每个页的物理地址，从kmalloc中分配
+    bool attached; // 是否被进程映射过
+    int creator;   // 创建该段的进程的pid
+};
+
+// 共享内存段的每个物理页由段本身持有一个引用，每个映射该段的进程再各持有一个引用
+// 段在被映射过且不再被任何进程映射后释放，从未被映射过的段在创建者退出后释放
+class SharedMemoryManager
+{
+public:
+    SharedSegment segments[MAX_SHARED_SEGMENTS];
+    // 累计创建的段数
+    int created;
+    // 累计释放的段数
+    int destroyed;
+
+public:
+    SharedMemoryManager();
+    void initialize();
+    // 创建size字节的共享内存段，物理页在创建时分配并清零
+    // 成功，返回段号；失败，返回-1
+    int create(const int size);
+    // 将第id个段映射到当前进程的用户地址空间，页可读写
+    // 成功，返回起始虚拟地址；失败，返回-1
+    int attach(const int id);
+    // 解除当前进程中从address开始的共享内存段的映射
+    // 成功，返回0；address不是共享内存段的起始地址，返回-1
+    int detach(const int address);
+    // 释放被映射过且不再被任何进程映射的段
+    // pid不为-1时，同时释放由进程pid创建且从未被映射过的段，在进程退出后调用
+    void collect(const int pid = -1);
+
+private:
+    // 释放第id个段的物理页和页表
+    void destroy(const int id);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "os_type.h"
+#include "list.h"
+
+#define SLAB_NAME_LENGTH 15
+// kmalloc的大小类别为16B, 32B, ..., 1024B
+#define SLAB_CLASS_AMOUNT 7
+#define SLAB_MIN_SIZE 16
+#define SLAB_MAX_SIZE 1024
+// 内存统计信息中至多包含的cache数量
+#define MAX_SLAB_CACHES 8
+
+class SlabCache;
+
+// 每个slab占用一页，页的开头存放SlabHeader
+struct SlabHeader
+{
+    ListItem tagInSlabList; // slab链表标识
+    SlabCache *cache;       // 所属的cache，nullptr表示kmalloc分配的大块内存
+    void *freeObject;       // 空闲对象链表，空闲对象的前4个字节指向下一个空闲对象
+    int inUse;              // 已分配的对象数量，大块内存时为页数
+};
+
+// cache的使用情况
+struct SlabStatistics
+{
+    char name[SLAB_NAME_LENGTH + 1]; // cache名
+    int objectSize;                  // 对象大小
+    int objectsPerSlab;              // 每个slab的对象数量
+    int slabs;                       // slab数量
+    int inUse;                       // 已分配的对象数量
+    int allocations;                 // 累计分配次数
+    int releases;                    // 累计释放次数
+};
+
+class SlabCache
+{
+public:
+    char name[SLAB_NAME_LENGTH + 1]; // cache名
+    int objectSize;                  // 对象大小
+    int objectsPerSlab;              // 每个slab的对象数量
+    int objectOffset;                // 第一个对象在slab中的偏移
+    List partialSlabs;               // 部分对象已分配的slab
+    List fullSlabs;                  // 全部对象已分配的slab
+    List emptySlabs;                 // 全部对象空闲的slab，至多保留1个
+    int slabs;                       // slab数量
+    int inUse;                       // 已分配的对象数量
+    int allocations;                 // 累计分配次数
+    int releases;                    // 累计释放次数
+    ListItem tagInCacheList;         // cache链表标识
+
+public:
+    SlabCache();
+    // 初始化cache并加入slabAllocator的cache链表
+    void initialize(const char *name, const int objectSize);
+    // 分配一个对象，失败返回nullptr
+    void *allocate();
+    // 释放一个对象
+    void release(void *object);
+    // 获取cache的使用情况
+    void getStatistics(SlabStatistics *statistics);
+
+private:
+    // 从内核地址池中分配一页作为新的slab
+    SlabHeader *createSlab();
+};
+
+// 类型为T的对象的cache
+template <typename T>
+class ObjectCache
+{
+public:
+    SlabCache cache;
+
+public:
+    void initialize(const char *name)
+    {
+        cache.initialize(name, sizeof(T));
+    }
+
+    // 分配一个T对象，对象的内容未初始化
+    T *allocate()
+    {
+        return (T *)cache.allocate();
+    }
+
+    void release(T *object)
+    {
+        cache.release(object);
+    }
+};
+
+class SlabAllocator
+{
+public:
+    SlabCache caches[SLAB_CLASS_AMOUNT]; // kmalloc使用的各个大小类别的cache
+    List allCaches;                      // 所有的cache
+
+public:
+    SlabAllocator();
+    void initialize();
+    // 分配size个字节，失败返回nullptr
+    void *allocate(const int size);
+    // 释放allocate返回的内存
+    void release(void *address);
+    // 将至多max个cache的使用情况写入statistics，返回写入的数量
+    int getStatistics(SlabStatistics *statistics, const int max);
+};
+
+// 分配size个字节的内核内存
+void *kmalloc(const int size);
+// 释放kmalloc分配的内核内存
+void kfree(void *address);
+
+#endif
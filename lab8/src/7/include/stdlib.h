@@ -18,8 +18,16 @@ void itos(char *numStr, uint32 num, uint32 mod);
 void memset(void *memory, char value, int length);
 // 上取整
 int ceil(const int dividend, const int divisor);
-// 内存复制，将src开始的length个字节复制到dst中
+// 内存复制，将src开始的length个字节复制到dst中，两者不能重叠
 void memcpy(void *src, void *dst, uint32 length);
+// 内存移动，将src开始的length个字节复制到dst中，两者可以重叠
+void memmove(void *src, void *dst, uint32 length);
+// 字符串长度
+int strlen(const char *str);
 // 字符串复制
 void strcpy(const char *src, char *dst);
+// 将4KB对齐的页清零
+void pageZero(void *page);
+// 将4KB对齐的页src复制到dst中
+void pageCopy(void *src, void *dst);
 #endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "bitmap.h"
+#include "os_type.h"
+
+class SwapManager
+{
+public:
+    // 交换区的页槽
+    BitMap slots;
+    // 页槽的引用计数，fork后父子进程可能共享同一个页槽
+    uint8 *slotReferences;
+    // CLOCK算法的指针，指向下一个检查的用户物理页的序号
+    int clockHand;
+    // 累计换出的页数
+    int swapOuts;
+    // 累计换入的页数
+    int swapIns;
+
+public:
+    SwapManager();
+    // 初始化交换区，需在内存管理器初始化后调用
+    void initialize();
+    // 按CLOCK算法选择一个用户物理页换出到交换区，选出页后才分配页槽
+    // 扫描、修改页表项和写入页槽都在关中断时进行，返回时恢复调用者的中断状态
+    // 成功，返回true；交换区已满或没有可以换出的页，返回false
+    bool swapOut();
+    // 将当前进程中address所在的已换出的页换入
+    // 由缺页中断处理函数调用，此时处理器已关中断，读入页槽时不会切换线程
+    // 成功，返回true；address所在的页未被换出或无法分配物理页，返回false
+    bool swapIn(const int address);
+    // 增加已换出的页表项pte对应的页槽的引用计数
+    void addReference(const int pte);
+    // 减少已换出的页表项pte对应的页槽的引用计数，减为0时释放页槽
+    void release(const int pte);
+
+private:
+    // 将第slot个页槽读入vaddr开始的页
+    void readPage(const int slot, const int vaddr);
+    // 将vaddr开始的页写入第slot个页槽
+    void writePage(const int slot, const int vaddr);
+};
+
+#endif
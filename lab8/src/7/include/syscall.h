@@ -2,6 +2,10 @@
 #define SYSCALL_H
 
 #include "os_constant.h"
+#include "benchmark.h"
+#include "memory.h"
+#include "program.h"
+#include "clock.h"
 
 class SystemService
 {
@@ -35,4 +39,48 @@ int syscall_wait(int *retval);
 void move_cursor(int i, int j);
 void syscall_move_cursor(int i, int j);
 
+// 第6个系统调用, benchmark，运行type指定的内核基准测试
+int benchmark(int type);
+int syscall_benchmark(int type);
+
+// 第7个系统调用, sbrk
+int sbrk(int increment);
+int syscall_sbrk(int increment);
+
+// 第8个系统调用, yield，让出处理器
+int yield();
+int syscall_yield();
+
+// 第9个系统调用, memory stat
+int memory_stat(MemoryStatistics *statistics);
+int syscall_memory_stat(MemoryStatistics *statistics);
+
+// 第10个系统调用, shm create
+int shm_create(int size);
+int syscall_shm_create(int size);
+
+// 第11个系统调用, shm attach
+int shm_attach(int id);
+int syscall_shm_attach(int id);
+
+// 第12个系统调用, shm detach
+int shm_detach(int address);
+int syscall_shm_detach(int address);
+
+// 第13个系统调用, cpu stat
+int cpu_stat(CPUStatistics *statistics);
+int syscall_cpu_stat(CPUStatistics *statistics);
+
+// 第14个系统调用, clock gettime，获取单调时钟
+int clock_gettime(TimeSpec *time);
+int syscall_clock_gettime(TimeSpec *time);
+
+// 第15个系统调用, nanosleep，阻塞至少request指定的时间
+int nanosleep(const TimeSpec *request);
+int syscall_nanosleep(const TimeSpec *request);
+
+// 第16个系统调用, process stat，获取至多max个用户进程的内存使用情况，返回获取的数量
+int process_stat(ProcessStatistics *statistics, int max);
+int syscall_process_stat(ProcessStatistics *statistics, int max);
+
 #endif
\ No newline at end of file
@@ -3,16 +3,29 @@
 
 #include "list.h"
 #include "os_constant.h"
-#include "address_pool.h"
+#include "vma.h"
+#include "os_type.h"
 
 typedef void (*ThreadFunction)(void *);
 
+struct PCB;
+
+// 公平调度的就绪线程按虚拟运行时间组成的AVL树的节点
+struct FairTreeNode
+{
+    PCB *left;    // 更早执行的线程
+    PCB *right;   // 更晚执行的线程
+    int height;   // 子树的高度
+    uint32 order; // 插入序号，虚拟运行时间相同时先插入的先执行
+};
+
 enum ProgramStatus
 {
     CREATED,
     RUNNING,
     READY,
     BLOCKED,
+    WAITING, // 在wait中等待子进程退出
     DEAD
 };
 
@@ -21,17 +34,24 @@ struct PCB
     int *stack;                      // 栈指针，用于调度时保存esp
     char name[MAX_PROGRAM_NAME + 1]; // 线程名
     enum ProgramStatus status;       // 线程的状态
-    int priority;                    // 线程优先级
+    int priority;                    // 线程优先级，数值越大越优先
     int pid;                         // 线程pid
     int ticks;                       // 线程时间片总时间
     int ticksPassedBy;               // 线程已执行时间
     ListItem tagInGeneralList;       // 线程队列标识
     ListItem tagInAllList;           // 线程队列标识
+    uint32 vruntime;                 // 公平调度的虚拟运行时间，按优先级加权
+    FairTreeNode tagInFairTree;      // 公平调度的就绪线程树中的节点
 
     int pageDirectoryAddress; // 页目录表地址
-    AddressPool userVirtual;  // 用户程序虚拟地址池
+    VirtualAreaTree userVirtual; // 用户程序已分配的虚拟地址空间
     int parentPid;            // 父进程pid
     int retValue;             // 返回值
+    int heapBreak;            // 用户进程堆的结束地址
+    int lazyPages;            // 延迟分配物理页的虚拟页数
+    int demandFaults;         // 首次访问时分配物理页的缺页次数
+    int cowFaults;            // 写时复制的缺页次数
+    int swapFaults;           // 从交换区换入页的缺页次数
 };
 
 #endif
\ No newline at end of file
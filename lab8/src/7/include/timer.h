@@ -0,0 +1,62 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "os_type.h"
+#include "os_constant.h"
+#include "list.h"
+
+typedef void (*TimerCallback)(void *data);
+
+// 一次性定时器，由调用者提供存储空间，到期或取消前不能释放
+struct Timer
+{
+    ListItem tagInWheel;    // 时间轮的槽中的节点
+    List *slot;             // 所在的槽，nullptr表示未添加或已到期
+    uint32 expires;         // 到期时的jiffies
+    TimerCallback callback; // 到期时在时钟中断中调用，此时处于关中断状态
+    void *data;             // callback的参数
+};
+
+// 分层时间轮，第0层的每个槽对应一个时钟中断，第i层的每个槽对应第i-1层转一圈的时间
+// 定时器按到期时间与当前时间的差放入最低的能够容纳的层
+// 低层转完一圈时，高层的下一个槽中的定时器被重新分配到低层
+// 添加、取消为O(1)，每个定时器至多被重新分配TIMER_LEVELS - 1次
+class TimerManager
+{
+public:
+    // 时间轮，wheel[i][j]为第i层的第j个槽
+    List wheel[TIMER_LEVELS][TIMER_SLOTS];
+    // 时间轮已经处理到的jiffies
+    uint32 current;
+    // 未到期的定时器数
+    int pending;
+    // 累计到期的定时器数
+    int expired;
+    // 累计被取消的定时器数
+    int cancelled;
+
+public:
+    TimerManager();
+    void initialize();
+    // timer在ticks个时钟中断后到期，到期时调用callback(data)
+    // 超过时间轮的范围时取可以表示的最长定时
+    void add(Timer *timer, uint32 ticks, TimerCallback callback, void *data);
+    // 取消未到期的timer
+    // 成功，返回true；timer未添加或已到期，返回false
+    bool cancel(Timer *timer);
+    // 当前线程阻塞ticks个时钟中断后被唤醒
+    void sleep(uint32 ticks);
+    // 时钟中断处理函数调用，调用到期的定时器的callback
+    void run();
+
+private:
+    // 根据到期时间将timer放入时间轮
+    void place(Timer *timer);
+    // 将第level层的第index个槽中的定时器重新分配到低层
+    void cascade(int level, int index);
+};
+
+// 内核线程阻塞至少ms毫秒
+void sleep_ms(int ms);
+
+#endif
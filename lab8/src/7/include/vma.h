@@ -0,0 +1,83 @@
+#ifndef VMA_H
+#define VMA_H
+
+#include "os_type.h"
+
+// 虚拟内存区域的类型，类型相同且相邻的区域会被合并
+enum VirtualAreaType
+{
+    ANONYMOUS_AREA, // 通过allocatePages分配的页
+    HEAP_AREA,      // 用户进程堆预留的地址空间
+    SHARED_AREA     // 映射的共享内存段
+};
+
+// 虚拟内存区域，包含从start开始到end之前的页
+struct VirtualArea
+{
+    uint32 start;              // 起始地址
+    uint32 end;                // 结束地址，不属于该区域，可以是0xc0000000
+    enum VirtualAreaType type; // 区域的类型
+    VirtualArea *left;         // 起始地址更小的区域
+    VirtualArea *right;        // 起始地址更大的区域
+    int height;                // 子树的高度
+};
+
+// 按起始地址排序的AVL树，描述用户进程已分配的虚拟地址空间
+// 区域之间互不重叠，节点从virtualAreaCache中分配
+class VirtualAreaTree
+{
+public:
+    VirtualArea *root;
+    // 区域的数量
+    int areas;
+    // 可分配的地址范围
+    uint32 startAddress;
+    uint32 endAddress;
+
+public:
+    VirtualAreaTree();
+    // 初始化为空树，可分配的地址范围为[startAddress, endAddress)
+    void initialize(const int startAddress, const int endAddress);
+    // 按首次适配分配count个连续页作为type类型的区域，成功则返回第一个页的地址，失败则返回-1
+    int allocate(const int count, enum VirtualAreaType type = VirtualAreaType::ANONYMOUS_AREA);
+    // 释放从address开始的amount个页，被部分释放的区域会被拆分
+    void release(const int address, const int amount);
+    // 将从address开始的amount个未分配的页标记为type类型的区域
+    // 成功，返回true；地址越界、与已有区域重叠或无法分配节点，返回false
+    bool reserve(const int address, const int amount, enum VirtualAreaType type);
+    // 返回包含address的区域，address未分配时返回nullptr
+    VirtualArea *find(const int address);
+    // 复制source中的所有区域，原有的区域被清除
+    // 成功，返回true；无法分配节点，返回false
+    bool copy(const VirtualAreaTree &source);
+    // 清除所有区域
+    void clear();
+
+private:
+    // 将[start, end)插入树中，与类型相同的相邻区域合并
+    bool insert(const uint32 start, const uint32 end, enum VirtualAreaType type);
+    // 在以node为根的子树中插入area，返回新的根
+    VirtualArea *insertNode(VirtualArea *node, VirtualArea *area);
+    // 在以node为根的子树中删除起始地址为start的区域，返回新的根
+    VirtualArea *removeNode(VirtualArea *node, const uint32 start);
+    // 返回树中与[start, end)重叠的一个区域，没有时返回nullptr
+    VirtualArea *findOverlap(const uint32 start, const uint32 end);
+    // 返回起始地址小于address的最后一个区域
+    VirtualArea *predecessor(const uint32 address);
+    // 返回起始地址不小于address的第一个区域
+    VirtualArea *successor(const uint32 address);
+    // 在以node为根的子树中查找长度至少为length字节的第一个空闲间隙
+    // previous为node子树之前最后一个区域的结束地址，返回间隙的起始地址，找不到时返回-1
+    int searchGap(VirtualArea *node, uint32 &previous, const uint32 length);
+    // 复制以node为根的子树，返回复制后的根
+    VirtualArea *copyNode(VirtualArea *node, bool &flag);
+    // 释放以node为根的子树的所有节点
+    void clearNode(VirtualArea *node);
+    // 重新计算node的高度，必要时旋转，返回新的根
+    VirtualArea *balance(VirtualArea *node);
+    VirtualArea *rotateLeft(VirtualArea *node);
+    VirtualArea *rotateRight(VirtualArea *node);
+    int height(VirtualArea *node);
+};
+
+#endif
@@ -68,9 +68,15 @@ load_kernel:
 call open_page_mechanism
 mov eax, PAGE_DIRECTORY
 mov cr3, eax ; 放入页目录表地址
+mov eax, cr4
+or eax, 0x10
+mov cr4, eax           ; 置PSE=1，页目录项可以直接映射4MB的页
 mov eax, cr0
-or eax, 0x80000000
-mov cr0, eax           ; 置PG=1，开启分页机制
+or eax, 0x80010000
+mov cr0, eax           ; 置PG=1，开启分页机制；置WP=1，内核写只读页同样引发缺页
+mov eax, cr4
+or eax, 0x80
+mov cr4, eax           ; 置PGE=1，G=1的页的TLB项在切换页目录表时保留
 
 sgdt [pgdt]
 add dword[pgdt + 2], 0xc0000000
@@ -31,6 +31,26 @@ load_bootloader:
     mov [0x7c00], ax
     mov [0x7c00+2], bx
 
+    ; 获取内存布局，E820h每次返回一个内存区域，ebx为0时表示已返回全部区域
+    mov dword [BOOT_INFO_ADDRESS], 0
+    mov di, BOOT_INFO_ADDRESS + 4
+    xor ebx, ebx
+get_memory_map:
+    mov eax, 0xe820
+    mov ecx, E820_ENTRY_SIZE
+    mov edx, 0x534d4150 ; 'SMAP'
+    int 15h
+    jc get_memory_map_done    ; 不支持E820h或已返回全部区域
+    cmp eax, 0x534d4150
+    jne get_memory_map_done
+    add di, E820_ENTRY_SIZE
+    inc dword [BOOT_INFO_ADDRESS]
+    cmp dword [BOOT_INFO_ADDRESS], E820_MAX_ENTRIES
+    jae get_memory_map_done
+    test ebx, ebx
+    jnz get_memory_map
+get_memory_map_done:
+
     jmp 0x0000:0x7e00        ; 跳转到bootloader
 
 jmp $ ; 死循环
@@ -1,10 +1,12 @@
 #include "os_constant.h"
+#include "os_type.h"
+#include "boot_info.h"
 
 extern "C" void open_page_mechanism()
 {
     // 页目录表指针
     int *directory = (int *)PAGE_DIRECTORY;
-    //线性地址0~4MB对应的页表
+    // 内核虚拟地址区对应的页表
     int *page = (int *)(PAGE_DIRECTORY + PAGE_SIZE);
 
     
@@ -12,25 +14,66 @@ extern "C" void open_page_mechanism()
     for(int i = 0; i < entryNum; ++i ) {
         // 初始化页目录表
         directory[i] = 0;
-        // 初始化线性地址0~4MB对应的页表
+        // 初始化内核虚拟地址区对应的页表
         page[i] = 0;
     }
 
-    int address = 0;
-    // 将线性地址0~1MB恒等映射到物理地址0~1MB
-    for (int i = 0; i < 256; ++i)
+    // 可用内存的最高地址，此时尚未开启分页，使用物理地址访问
+    BootInfo *info = (BootInfo *)(BOOT_INFO_ADDRESS - KERNEL_DIRECT_MAP_START);
+    uint32 top = 0;
+    for (uint32 i = 0; i < info->e820Count && i < E820_MAX_ENTRIES; ++i)
     {
-        // U/S = 1, R/W = 1, P = 1
-        page[i] = address | 0x7;
-        address += PAGE_SIZE;
+        E820Entry *entry = &info->e820[i];
+        if (entry->type != E820_USABLE || entry->baseHigh || entry->baseLow >= MAX_PHYSICAL_ADDRESS)
+        {
+            continue;
+        }
+
+        uint32 end = entry->baseLow + entry->lengthLow;
+        if (entry->lengthHigh || end < entry->baseLow || end > MAX_PHYSICAL_ADDRESS)
+        {
+            end = MAX_PHYSICAL_ADDRESS;
+        }
+        if (end > top)
+        {
+            top = end;
+        }
+    }
+
+    // 不支持E820h时使用E801h的结果，E801h返回的是1MB以上的内存容量
+    if (!top)
+    {
+        uint32 memory = *((uint32 *)(MEMORY_SIZE_ADDRESS - KERNEL_DIRECT_MAP_START));
+        top = (memory & 0xffff) * 1024 + ((memory >> 16) & 0xffff) * 64 * 1024 + 0x100000;
+        if (top > MAX_PHYSICAL_ADDRESS)
+        {
+            top = MAX_PHYSICAL_ADDRESS;
+        }
+    }
+
+    // 按4MB的页向上取整，至多映射到内核虚拟地址区之前
+    uint32 largePages = (top + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE;
+    uint32 maxLargePages = (KERNEL_VIRTUAL_START - KERNEL_DIRECT_MAP_START) / LARGE_PAGE_SIZE;
+    if (largePages > maxLargePages)
+    {
+        largePages = maxLargePages;
     }
 
     // 初始化页目录项
 
-    // 0~1MB
-    directory[0] = ((int)page) | 0x07;
-    // 3GB的内核空间
-    directory[768] = directory[0];
+    // 将线性地址3GB开始的内核空间直接映射到物理地址0开始的全部内存，每个页目录项映射一个4MB的页
+    // 内核空间被所有进程共享，标记为全局页，切换页目录表时TLB项得以保留
+    // G = 1, PS = 1, U/S = 1, R/W = 1, P = 1
+    uint32 address = 0;
+    for (uint32 i = 0; i < largePages; ++i)
+    {
+        directory[768 + i] = address | PAGE_GLOBAL | 0x87;
+        address += LARGE_PAGE_SIZE;
+    }
+    // 0~4MB恒等映射，开启分页后bootloader仍在低地址执行，用户进程没有该映射，不能是全局页
+    directory[0] = directory[768] & ~PAGE_GLOBAL;
+    // 内核虚拟地址区由4KB的页映射，页表被所有进程共享
+    directory[(KERNEL_VIRTUAL_START >> 22) & 0x3ff] = ((int)page) | 0x7;
     // 最后一个页目录项指向页目录表
     directory[1023] = ((int)directory) | 0x7;
-}
\ No newline at end of file
+}
@@ -0,0 +1,994 @@
+#include "benchmark.h"
+#include "asm_utils.h"
+#include "bitmap.h"
+#include "list.h"
+#include "run_queue.h"
+#include "stdlib.h"
+#include "os_modules.h"
+#include "stdio.h"
+#include "syscall.h"
+
+int run_benchmark(int type)
+{
+    switch (type)
+    {
+    case BITMAP_BENCHMARK:
+        bitmap_benchmark();
+        break;
+    case FAULT_BENCHMARK:
+        fault_benchmark();
+        break;
+    case MAPPING_BENCHMARK:
+        mapping_benchmark();
+        break;
+    case TLB_BENCHMARK:
+        tlb_benchmark();
+        break;
+    case SWITCH_BENCHMARK:
+        switch_benchmark();
+        break;
+    case STRING_BENCHMARK:
+        string_benchmark();
+        break;
+    case LIST_BENCHMARK:
+        list_benchmark();
+        break;
+    case DISPATCH_BENCHMARK:
+        dispatch_benchmark();
+        break;
+    case FAIR_BENCHMARK:
+        fair_benchmark();
+        break;
+    case SPAWN_BENCHMARK:
+        spawn_benchmark();
+        break;
+    default:
+        return -1;
+    }
+
+    return 0;
+}
+
+// 逐位查找的首次适配，作为按字查找的对照
+static int bitmap_first_fit(BitMap &bitmap)
+{
+    for (int i = 0; i < bitmap.length; ++i)
+    {
+        if (!bitmap.get(i))
+        {
+            bitmap.set(i, true);
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void bitmap_benchmark()
+{
+    // 一页的位图管理32768个资源，相当于128MB的物理页
+    char *page = (char *)memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
+    if (!page)
+    {
+        printf("bench bitmap: can not allocate page\n");
+        return;
+    }
+
+    int length = PAGE_SIZE * 8;
+    int percents[] = {0, 25, 50, 75, 90, 99};
+    int levels = sizeof(percents) / sizeof(int);
+    const char *names[] = {"  next fit: ", "  word scan:", "  bit scan: "};
+    BitMap bitmap;
+
+    // 空闲的资源均匀地散布在整个位图中，游标之后总要越过已分配的资源才能找到空闲的资源
+    printf("bench bitmap: allocate(1) cycles at fill 0/25/50/75/90/99%%, scattered holes\n");
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        printf(names[mode]);
+        for (int i = 0; i < levels; ++i)
+        {
+            int free = length - length / 100 * percents[i];
+
+            bitmap.initialize(page, length);
+            bitmap.reserve(0, length);
+            for (int k = 0; k < free; ++k)
+            {
+                bitmap.release(k * length / free, 1);
+            }
+
+            bool status = interruptManager.getInterruptStatus();
+            interruptManager.disableInterrupt();
+            uint64 start = asm_read_tsc();
+            for (int j = 0; j < BENCHMARK_ROUNDS; ++j)
+            {
+                if (mode == 0)
+                {
+                    // 从上次分配之后继续查找
+                    bitmap.allocate(1);
+                }
+                else if (mode == 1)
+                {
+                    // 每次都从头按字查找，与逐位查找扫描相同的范围
+                    bitmap.hint = 0;
+                    bitmap.allocate(1);
+                }
+                else
+                {
+                    bitmap_first_fit(bitmap);
+                }
+            }
+            uint64 cycles = asm_read_tsc() - start;
+            interruptManager.setInterruptStatus(status);
+
+            printf(" %d", asm_divide(cycles, BENCHMARK_ROUNDS));
+        }
+        printf("\n");
+    }
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)page, 1);
+}
+
+// 直接从用户物理地址池中分配一页，不设置引用计数，也不会触发换出
+static int take_user_frame()
+{
+    if (memoryManager.backend == PhysicalPoolBackend::BUDDY_BACKEND)
+        return memoryManager.userBuddy.allocate(1);
+    else
+        return memoryManager.userPhysical.allocate(1);
+}
+
+static void give_user_frame(const int paddr)
+{
+    if (memoryManager.backend == PhysicalPoolBackend::BUDDY_BACKEND)
+        memoryManager.userBuddy.release(paddr, 1);
+    else
+        memoryManager.userPhysical.release(paddr, 1);
+}
+
+// 占用空闲的用户物理页和预先清零的页，只留下free个空闲页
+// 被占用的页没有反向映射，不能被换出，串成链表，每页的第一个字存放下一页的物理地址，返回链表头
+static int pin_user_frames(const int free)
+{
+    int head = 0;
+    int paddr;
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    while ((paddr = memoryManager.userZeroPages.allocate()))
+    {
+        memoryManager.setFrameMapping(paddr, nullptr, 0);
+        *(int *)phys2virt(paddr) = head;
+        head = paddr;
+    }
+
+    while ((paddr = take_user_frame()) != -1)
+    {
+        memoryManager.setFrameMapping(paddr, nullptr, 0);
+        *(int *)phys2virt(paddr) = head;
+        head = paddr;
+    }
+
+    // 归还链表头部的free个页
+    for (int i = 0; i < free && head; ++i)
+    {
+        paddr = head;
+        head = *(int *)phys2virt(paddr);
+        give_user_frame(paddr);
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return head;
+}
+
+// 释放pin_user_frames占用的页
+static void unpin_user_frames(int head)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    while (head)
+    {
+        int next = *(int *)phys2virt(head);
+        give_user_frame(head);
+        head = next;
+    }
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void fault_benchmark()
+{
+    // 工作集从远小于空闲页数到空闲页数的两倍
+    int sizes[] = {16, 32, 48, 56, 72, 96, 128};
+    int levels = sizeof(sizes) / sizeof(int);
+    int passes = 4;
+    PCB *process = programManager.running;
+
+    int pinned = pin_user_frames(FAULT_BENCHMARK_FRAMES);
+
+    printf("bench fault: %d free frames, faults per 100 accesses, cycles per access\n",
+           FAULT_BENCHMARK_FRAMES);
+    for (int i = 0; i < levels; ++i)
+    {
+        int pages = sizes[i];
+        int vaddr = memoryManager.allocatePages(AddressPoolType::USER, pages);
+        if (!vaddr)
+        {
+            printf("  %d pages: can not allocate\n", pages);
+            break;
+        }
+
+        // 第0遍首次访问，不计入
+        int faults = 0;
+        uint64 cycles = 0;
+        for (int pass = 0; pass <= passes; ++pass)
+        {
+            int before = process->demandFaults + process->swapFaults;
+            uint64 start = asm_read_tsc();
+            for (int j = 0; j < pages; ++j)
+            {
+                ((volatile char *)vaddr)[j * PAGE_SIZE] = pass;
+            }
+
+            if (pass)
+            {
+                cycles += asm_read_tsc() - start;
+                faults += process->demandFaults + process->swapFaults - before;
+            }
+        }
+
+        printf("  %d pages: %d faults, %d cycles\n", pages,
+               faults * 100 / (pages * passes), asm_divide(cycles, pages * passes));
+
+        memoryManager.releasePages(AddressPoolType::USER, vaddr, pages);
+    }
+
+    unpin_user_frames(pinned);
+}
+
+void mapping_benchmark()
+{
+    int sizes[] = {1, 16, 256};
+    int levels = sizeof(sizes) / sizeof(int);
+    int rounds = 16;
+
+    printf("bench mapping: map + unmap cycles per page, batch / per page\n");
+    for (int i = 0; i < levels; ++i)
+    {
+        int pages = sizes[i];
+        int vaddr = memoryManager.allocateVirtualPages(AddressPoolType::KERNEL, pages);
+        if (!vaddr)
+        {
+            printf("  %d pages: can not allocate\n", pages);
+            break;
+        }
+
+        uint64 cycles[2] = {0, 0};
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            for (int round = 0; round < rounds; ++round)
+            {
+                // unmapPages会释放物理页，每一轮重新分配
+                int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::KERNEL, pages);
+                if (!paddr)
+                {
+                    break;
+                }
+
+                bool status = interruptManager.getInterruptStatus();
+                interruptManager.disableInterrupt();
+                uint64 start = asm_read_tsc();
+                if (mode)
+                {
+                    for (int j = 0; j < pages; ++j)
+                    {
+                        memoryManager.connectPhysicalVirtualPage(vaddr + j * PAGE_SIZE, paddr + j * PAGE_SIZE);
+                    }
+                    for (int j = 0; j < pages; ++j)
+                    {
+                        memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr + j * PAGE_SIZE, 1);
+                    }
+                }
+                else
+                {
+                    memoryManager.connectPhysicalVirtualPages(vaddr, paddr, pages);
+                    memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr, pages);
+                }
+                cycles[mode] += asm_read_tsc() - start;
+                interruptManager.setInterruptStatus(status);
+            }
+        }
+
+        printf("  %d pages: %d / %d\n", pages,
+               asm_divide(cycles[0], pages * rounds), asm_divide(cycles[1], pages * rounds));
+
+        memoryManager.releaseVirtualPages(AddressPoolType::KERNEL, vaddr, pages);
+    }
+
+    // 逐页分配时记录每一页的地址
+    int *addresses = (int *)memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
+    if (!addresses)
+    {
+        printf("bench mapping: can not allocate page\n");
+        return;
+    }
+
+    printf("bench mapping: allocatePages + releasePages cycles per page, at once / per page\n");
+    for (int i = 0; i < levels; ++i)
+    {
+        int pages = sizes[i];
+        uint64 cycles[2] = {0, 0};
+        bool failed = false;
+
+        for (int mode = 0; mode < 2 && !failed; ++mode)
+        {
+            for (int round = 0; round < rounds && !failed; ++round)
+            {
+                bool status = interruptManager.getInterruptStatus();
+                interruptManager.disableInterrupt();
+                uint64 start = asm_read_tsc();
+                if (mode)
+                {
+                    for (int j = 0; j < pages; ++j)
+                    {
+                        addresses[j] = memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
+                        failed = failed || !addresses[j];
+                    }
+                    for (int j = 0; j < pages; ++j)
+                    {
+                        if (addresses[j])
+                        {
+                            memoryManager.releasePages(AddressPoolType::KERNEL, addresses[j], 1);
+                        }
+                    }
+                }
+                else
+                {
+                    int vaddr = memoryManager.allocatePages(AddressPoolType::KERNEL, pages);
+                    failed = !vaddr;
+                    if (vaddr)
+                    {
+                        memoryManager.releasePages(AddressPoolType::KERNEL, vaddr, pages);
+                    }
+                }
+                cycles[mode] += asm_read_tsc() - start;
+                interruptManager.setInterruptStatus(status);
+            }
+        }
+
+        if (failed)
+        {
+            printf("  %d pages: can not allocate\n", pages);
+            break;
+        }
+
+        printf("  %d pages: %d / %d\n", pages,
+               asm_divide(cycles[0], pages * rounds), asm_divide(cycles[1], pages * rounds));
+    }
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)addresses, 1);
+}
+
+void tlb_benchmark()
+{
+    // 2MB，远超过4KB页的TLB项数能覆盖的范围
+    int pages = 512;
+    int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::KERNEL, pages);
+    if (!paddr)
+    {
+        pages = 256;
+        paddr = memoryManager.allocatePhysicalPages(AddressPoolType::KERNEL, pages);
+    }
+
+    int vaddr = paddr ? memoryManager.allocateVirtualPages(AddressPoolType::KERNEL, pages) : 0;
+    int mapped = vaddr ? memoryManager.connectPhysicalVirtualPages(vaddr, paddr, pages) : 0;
+    if (mapped != pages)
+    {
+        printf("bench tlb: can not map pages\n");
+        // 已映射的物理页由unmapPages释放
+        if (vaddr)
+        {
+            memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr, mapped);
+            memoryManager.releaseVirtualPages(AddressPoolType::KERNEL, vaddr, pages);
+        }
+        if (paddr)
+        {
+            memoryManager.releasePhysicalPages(AddressPoolType::KERNEL, paddr + mapped * PAGE_SIZE, pages - mapped);
+        }
+        return;
+    }
+
+    // 第0个为直接映射区中的4MB页，第1个为内核虚拟地址区中的4KB页
+    int bases[2] = {phys2virt(paddr), vaddr};
+    uint32 cycles[2];
+    int passes = 16;
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        uint64 total = 0;
+        // 第0遍装入cache，不计入
+        for (int pass = 0; pass <= passes; ++pass)
+        {
+            uint64 start = asm_read_tsc();
+            for (int j = 0; j < pages; ++j)
+            {
+                // 每页访问不同的cache行，避免集中在同一个cache组
+                (void)*(volatile int *)(bases[mode] + j * PAGE_SIZE + (j % 64) * 64);
+            }
+            if (pass)
+            {
+                total += asm_read_tsc() - start;
+            }
+        }
+        cycles[mode] = asm_divide(total, pages * passes);
+    }
+    interruptManager.setInterruptStatus(status);
+
+    printf("bench tlb: %d pages, cycles per access 4MB %d / 4KB %d\n", pages, cycles[0], cycles[1]);
+
+    // 同时释放物理页
+    memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr, pages);
+    memoryManager.releaseVirtualPages(AddressPoolType::KERNEL, vaddr, pages);
+}
+
+// 让出处理器SWITCH_BENCHMARK_ROUNDS次，另一个线程是唯一的同优先级就绪线程，每次让出都切换到它
+static void switch_thread(void *arg)
+{
+    SwitchBenchmark *benchmark = (SwitchBenchmark *)arg;
+
+    interruptManager.disableInterrupt();
+    if (!benchmark->start)
+    {
+        benchmark->start = asm_read_tsc();
+    }
+
+    for (int i = 0; i < SWITCH_BENCHMARK_ROUNDS; ++i)
+    {
+        programManager.schedule();
+
+        // 对照组在切换后重新加载CR3，相当于每次调度都写入CR3
+        if (benchmark->reload)
+        {
+            asm_update_cr3(asm_read_cr3());
+        }
+
+        // 被刷新的TLB项在访问时重新遍历页表
+        for (int j = 0; j < benchmark->pages; ++j)
+        {
+            *(volatile int *)(benchmark->base + j * PAGE_SIZE);
+        }
+    }
+
+    if (++benchmark->finished == benchmark->threads)
+    {
+        benchmark->end = asm_read_tsc();
+        benchmark->done.V();
+    }
+    interruptManager.enableInterrupt();
+}
+
+// 运行一次线程切换测试，返回每次切换的平均耗时，失败返回-1
+static int run_switch(const bool reload, const int base)
+{
+    SwitchBenchmark benchmark;
+    benchmark.threads = 0;
+    benchmark.finished = 0;
+    benchmark.start = 0;
+    benchmark.end = 0;
+    benchmark.done.initialize(0);
+    benchmark.reload = reload;
+    benchmark.base = base;
+    benchmark.pages = SWITCH_BENCHMARK_PAGES;
+
+    // 两个线程都创建后才开始执行
+    int priority = programManager.running->priority;
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+    for (int i = 0; i < 2; ++i)
+    {
+        if (programManager.executeThread(switch_thread, &benchmark, "switch", priority) != -1)
+        {
+            ++benchmark.threads;
+        }
+    }
+
+    // 信号量在关中断时释放，这里同样关中断等待，benchmark在线程退出前不能失效
+    if (benchmark.threads)
+    {
+        benchmark.done.P();
+    }
+    interruptManager.setInterruptStatus(status);
+
+    if (benchmark.threads < 2)
+    {
+        return -1;
+    }
+
+    return asm_divide(benchmark.end - benchmark.start, 2 * SWITCH_BENCHMARK_ROUNDS);
+}
+
+void switch_benchmark()
+{
+    // 内核虚拟地址区中的页由4KB的全局页表项映射
+    int pages = SWITCH_BENCHMARK_PAGES;
+    int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::KERNEL, pages);
+    int vaddr = paddr ? memoryManager.allocateVirtualPages(AddressPoolType::KERNEL, pages) : 0;
+    int mapped = vaddr ? memoryManager.connectPhysicalVirtualPages(vaddr, paddr, pages) : 0;
+    if (mapped != pages)
+    {
+        printf("bench switch: can not map pages\n");
+        // 已映射的物理页由unmapPages释放
+        if (vaddr)
+        {
+            memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr, mapped);
+            memoryManager.releaseVirtualPages(AddressPoolType::KERNEL, vaddr, pages);
+        }
+        if (paddr)
+        {
+            memoryManager.releasePhysicalPages(AddressPoolType::KERNEL, paddr + mapped * PAGE_SIZE, pages - mapped);
+        }
+        return;
+    }
+
+    int cycles[3];
+    cycles[0] = run_switch(false, vaddr);
+    cycles[1] = run_switch(true, vaddr);
+
+    // 关闭CR4.PGE后全局页表项也随CR3的重新加载而失效，即使用全局页之前的情况
+    int cr4 = asm_read_cr4();
+    asm_write_cr4(cr4 & ~0x80);
+    cycles[2] = run_switch(true, vaddr);
+    asm_write_cr4(cr4);
+
+    memoryManager.unmapPages(AddressPoolType::KERNEL, vaddr, pages);
+    memoryManager.releaseVirtualPages(AddressPoolType::KERNEL, vaddr, pages);
+
+    if (cycles[0] == -1 || cycles[1] == -1 || cycles[2] == -1)
+    {
+        printf("bench switch: can not execute thread\n");
+        return;
+    }
+
+    printf("bench switch: kernel thread touching %d pages, %d cycles; cr3 reload %d; cr3 reload without PGE %d\n",
+           pages, cycles[0], cycles[1], cycles[2]);
+}
+
+// 逐字节的实现，作为串操作指令的对照
+static void byte_memset(char *memory, char value, int length)
+{
+    for (int i = 0; i < length; ++i)
+    {
+        memory[i] = value;
+    }
+}
+
+static void byte_memcpy(const char *src, char *dst, int length)
+{
+    for (int i = 0; i < length; ++i)
+    {
+        dst[i] = src[i];
+    }
+}
+
+static void byte_memmove(const char *src, char *dst, int length)
+{
+    if (dst > src)
+    {
+        for (int i = length - 1; i >= 0; --i)
+        {
+            dst[i] = src[i];
+        }
+    }
+    else
+    {
+        byte_memcpy(src, dst, length);
+    }
+}
+
+// 对长度为length的操作operation，mode为0时使用串操作指令，为1时逐字节，返回平均耗时
+static uint32 string_cycles(char *src, char *dst, const int length, const int operation, const int mode)
+{
+    uint64 start = asm_read_tsc();
+    for (int i = 0; i < BENCHMARK_ROUNDS; ++i)
+    {
+        if (operation == 0)
+        {
+            mode ? byte_memset(dst, i, length) : memset(dst, i, length);
+        }
+        else if (operation == 1)
+        {
+            mode ? byte_memcpy(src, dst, length) : memcpy(src, dst, length);
+        }
+        else
+        {
+            // 目的区域与源区域重叠且在其之后，需要从后向前复制
+            mode ? byte_memmove(src, src + 8, length) : memmove(src, src + 8, length);
+        }
+    }
+    return asm_divide(asm_read_tsc() - start, BENCHMARK_ROUNDS);
+}
+
+void string_benchmark()
+{
+    // 两个64KB的缓冲区，memmove在源缓冲区之后留出重叠的部分
+    int pages = 2 * 65536 / PAGE_SIZE + 1;
+    char *src = (char *)memoryManager.allocatePages(AddressPoolType::KERNEL, pages);
+    if (!src)
+    {
+        printf("bench string: can not allocate pages\n");
+        return;
+    }
+    char *dst = src + 65536 + PAGE_SIZE;
+
+    int sizes[] = {8, 64, 512, 4096, 65536};
+    int levels = sizeof(sizes) / sizeof(int);
+
+    printf("bench string: cycles per call, rep / byte loop\n");
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+    for (int i = 0; i < levels; ++i)
+    {
+        uint32 cycles[3][2];
+        for (int operation = 0; operation < 3; ++operation)
+        {
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                cycles[operation][mode] = string_cycles(src, dst, sizes[i], operation, mode);
+            }
+        }
+
+        printf("  %d B: memset %d/%d, memcpy %d/%d, memmove %d/%d\n", sizes[i],
+               cycles[0][0], cycles[0][1], cycles[1][0], cycles[1][1], cycles[2][0], cycles[2][1]);
+    }
+    interruptManager.setInterruptStatus(status);
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)src, pages);
+}
+
+void list_benchmark()
+{
+    int length = 1024;
+    int pages = ceil(length * sizeof(ListItem), PAGE_SIZE);
+    ListItem *items = (ListItem *)memoryManager.allocatePages(AddressPoolType::KERNEL, pages);
+    if (!items)
+    {
+        printf("bench list: can not allocate pages\n");
+        return;
+    }
+
+    List list;
+    list.initialize();
+    uint32 cycles[5];
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    uint64 start = asm_read_tsc();
+    for (int i = 0; i < length; ++i)
+    {
+        list.push_back(&items[i]);
+    }
+    cycles[0] = asm_divide(asm_read_tsc() - start, length);
+
+    // 取出中间的元素再放回，链表长度保持不变
+    start = asm_read_tsc();
+    for (int i = 0; i < BENCHMARK_ROUNDS; ++i)
+    {
+        list.erase(&items[length / 2]);
+        list.push_back(&items[length / 2]);
+    }
+    cycles[1] = asm_divide(asm_read_tsc() - start, BENCHMARK_ROUNDS);
+
+    start = asm_read_tsc();
+    for (int i = 0; i < BENCHMARK_ROUNDS; ++i)
+    {
+        list.at(length / 2);
+    }
+    cycles[2] = asm_divide(asm_read_tsc() - start, BENCHMARK_ROUNDS);
+
+    start = asm_read_tsc();
+    for (int i = 0; i < BENCHMARK_ROUNDS; ++i)
+    {
+        ListItem *item = list.at(length / 2);
+        list.erase(length / 2);
+        list.push_back(item);
+    }
+    cycles[3] = asm_divide(asm_read_tsc() - start, BENCHMARK_ROUNDS);
+
+    start = asm_read_tsc();
+    while (list.front())
+    {
+        list.pop_front();
+    }
+    cycles[4] = asm_divide(asm_read_tsc() - start, length);
+
+    interruptManager.setInterruptStatus(status);
+
+    printf("bench list: %d items, cycles push_back %d, erase(item) %d, at(n/2) %d, at+erase(n/2) %d, pop_front %d\n",
+           length, cycles[0], cycles[1], cycles[2], cycles[3], cycles[4]);
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)items, pages);
+}
+
+// 在单个队列中顺序查找优先级最高的线程，优先级相同时先加入的优先
+static PCB *dispatch_scan(List &list)
+{
+    PCB *best = nullptr;
+    for (PCB *program = list.first(&PCB::tagInGeneralList); program;
+         program = list.next(program, &PCB::tagInGeneralList))
+    {
+        if (!best || program->priority > best->priority)
+        {
+            best = program;
+        }
+    }
+
+    if (best)
+    {
+        list.erase(&(best->tagInGeneralList));
+    }
+    return best;
+}
+
+void dispatch_benchmark()
+{
+    // 512个线程分布在8个优先级上，取出的线程换到另一个优先级后放回
+    const int amount = 512;
+    const int levels = 8;
+    int step = PRIORITY_LEVELS / levels;
+    int rounds = 4096;
+    int pages = ceil(amount * sizeof(PCB) + sizeof(PriorityRunQueue) + sizeof(List), PAGE_SIZE);
+    char *page = (char *)memoryManager.allocatePages(AddressPoolType::KERNEL, pages);
+    if (!page)
+    {
+        printf("bench dispatch: can not allocate pages\n");
+        return;
+    }
+
+    // 线程只用于测试，不会被执行
+    PCB *programs = (PCB *)page;
+    PriorityRunQueue *queue = (PriorityRunQueue *)(programs + amount);
+    List *list = (List *)(queue + 1);
+    // 按取出的线程的优先级累计，pick为选出并取下线程的耗时，dispatch还包括放回
+    uint64 pick[2][levels];
+    uint64 dispatch[2][levels];
+    int count[levels];
+    uint32 check[2];
+
+    memset(count, 0, sizeof(count));
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        memset(page, 0, pages * PAGE_SIZE);
+        queue->initialize();
+        list->initialize();
+        for (int i = 0; i < amount; ++i)
+        {
+            programs[i].priority = ((i * 5) % levels) * step;
+            mode ? list->push_back(&(programs[i].tagInGeneralList)) : queue->push_back(&programs[i]);
+        }
+
+        for (int i = 0; i < levels; ++i)
+        {
+            pick[mode][i] = 0;
+            dispatch[mode][i] = 0;
+        }
+
+        // 两种方式选出的线程的优先级序列应当相同
+        check[mode] = 0;
+        for (int round = 0; round < rounds; ++round)
+        {
+            PCB *program;
+            uint64 start = asm_read_tsc();
+            if (mode)
+            {
+                program = dispatch_scan(*list);
+            }
+            else
+            {
+                program = queue->front();
+                queue->pop_front();
+            }
+            uint64 picked = asm_read_tsc();
+
+            int level = program->priority / step;
+            check[mode] += program->priority * (round + 1);
+            program->priority = (program->priority + 3 * step) % PRIORITY_LEVELS;
+            mode ? list->push_back(&(program->tagInGeneralList)) : queue->push_back(program);
+            uint64 end = asm_read_tsc();
+
+            pick[mode][level] += picked - start;
+            dispatch[mode][level] += end - start;
+            if (!mode)
+            {
+                ++count[level];
+            }
+        }
+    }
+    interruptManager.setInterruptStatus(status);
+
+    printf("bench dispatch: %d threads, %d rounds, cycles per pick / dispatch, order %s\n",
+           amount, rounds, check[0] == check[1] ? "ok" : "FAIL");
+    for (int i = levels - 1; i >= 0; --i)
+    {
+        if (!count[i])
+        {
+            continue;
+        }
+
+        printf("  priority %d: %d picks, run queue %d / %d, scan %d / %d\n",
+               i * step, count[i],
+               asm_divide(pick[0][i], count[i]), asm_divide(dispatch[0][i], count[i]),
+               asm_divide(pick[1][i], count[i]), asm_divide(dispatch[1][i], count[i]));
+    }
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)page, pages);
+}
+
+// 一直就绪的线程，统计自己执行时经过的时钟中断数
+static void fair_thread(void *arg)
+{
+    FairBenchmark *benchmark = (FairBenchmark *)arg;
+    volatile uint32 *ticks = &jiffies;
+
+    // 线程在所有线程创建后才开始执行，此时pids已经填写
+    int index = 0;
+    while (benchmark->pids[index] != programManager.running->pid)
+    {
+        ++index;
+    }
+
+    // 执行时每看到一次jiffies变化记一个时钟中断，被抢占后恢复时只记一次
+    uint32 last = *ticks;
+    while (!benchmark->stop)
+    {
+        if (*ticks != last)
+        {
+            last = *ticks;
+            ++benchmark->ticks[index];
+        }
+    }
+
+    interruptManager.disableInterrupt();
+    if (++benchmark->finished == benchmark->threads)
+    {
+        benchmark->done.V();
+    }
+    interruptManager.enableInterrupt();
+}
+
+// 周期性睡眠的线程，统计到期后到再次执行经过的时钟中断数
+static void fair_sleeper(void *arg)
+{
+    FairBenchmark *benchmark = (FairBenchmark *)arg;
+    volatile uint32 *ticks = &jiffies;
+
+    while (!benchmark->stop)
+    {
+        uint32 expires = *ticks + FAIR_BENCHMARK_SLEEP;
+        timerManager.sleep(FAIR_BENCHMARK_SLEEP);
+
+        int latency = *ticks - expires;
+        benchmark->latency += latency;
+        if (latency > benchmark->maxLatency)
+        {
+            benchmark->maxLatency = latency;
+        }
+        ++benchmark->wakeups;
+    }
+
+    interruptManager.disableInterrupt();
+    if (++benchmark->finished == benchmark->threads)
+    {
+        benchmark->done.V();
+    }
+    interruptManager.enableInterrupt();
+}
+
+void fair_benchmark()
+{
+    if (programManager.policy != SchedulingPolicy::FAIR_POLICY)
+    {
+        printf("bench fair: skipped, scheduling policy is not fair (make build FAIR=1)\n");
+        return;
+    }
+
+    int priorities[] = {0, 3, 6, 9};
+    FairBenchmark benchmark;
+    memset(&benchmark, 0, sizeof(FairBenchmark));
+    benchmark.done.initialize(0);
+
+    // 所有线程都创建后才开始执行
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+    for (int i = 0; i < 4; ++i)
+    {
+        benchmark.pids[i] = programManager.executeThread(fair_thread, &benchmark, "fair", priorities[i]);
+        if (benchmark.pids[i] != -1)
+        {
+            ++benchmark.threads;
+        }
+    }
+    if (programManager.executeThread(fair_sleeper, &benchmark, "fair sleeper", 3) != -1)
+    {
+        ++benchmark.threads;
+    }
+    interruptManager.setInterruptStatus(status);
+
+    timerManager.sleep(FAIR_BENCHMARK_TICKS);
+    benchmark.stop = true;
+
+    // 信号量在关中断时释放，这里同样关中断等待，benchmark在线程退出前不能失效
+    interruptManager.disableInterrupt();
+    if (benchmark.threads)
+    {
+        benchmark.done.P();
+    }
+    interruptManager.setInterruptStatus(status);
+
+    if (benchmark.threads < 5)
+    {
+        printf("bench fair: can not execute thread\n");
+        return;
+    }
+
+    int sum = benchmark.ticks[0] + benchmark.ticks[1] + benchmark.ticks[2] + benchmark.ticks[3];
+    int weights = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        weights += priorities[i] + 1;
+    }
+
+    if (!sum)
+    {
+        sum = 1;
+    }
+
+    printf("bench fair: weights 1/4/7/10 over %d ticks, share %d/%d/%d/%d per mille, expect %d/%d/%d/%d\n",
+           FAIR_BENCHMARK_TICKS,
+           benchmark.ticks[0] * 1000 / sum, benchmark.ticks[1] * 1000 / sum,
+           benchmark.ticks[2] * 1000 / sum, benchmark.ticks[3] * 1000 / sum,
+           1000 / weights, 4000 / weights, 7000 / weights, 10000 / weights);
+    printf("bench fair: %d wakeups after %d ticks asleep, latency total %d max %d ticks, slice %d\n",
+           benchmark.wakeups, FAIR_BENCHMARK_SLEEP, benchmark.latency, benchmark.maxLatency, FAIR_TIME_SLICE);
+}
+
+// 在用户态执行，立即退出
+static void spawn_process()
+{
+    exit(0);
+}
+
+void spawn_benchmark()
+{
+    // 之前的测试中退出的内核线程在下一次调度时才归还PCB
+    timerManager.sleep(1);
+
+    int before = programManager.countPCB();
+    int spawned = 0;
+
+    for (int i = 0; i < SPAWN_BENCHMARK_ROUNDS; ++i)
+    {
+        if (programManager.executeProcess((const char *)spawn_process, 1) == -1)
+        {
+            break;
+        }
+        ++spawned;
+
+        // 等待进程退出且回收线程归还其PCB，至多等待1秒
+        for (int tick = 0; tick < HZ && programManager.countPCB() != before; ++tick)
+        {
+            timerManager.sleep(1);
+        }
+    }
+
+    int after = programManager.countPCB();
+    printf("bench spawn: %d of %d processes without parent exited, PCBs in use %d before / %d after, %s\n",
+           spawned, SPAWN_BENCHMARK_ROUNDS, before, after,
+           spawned == SPAWN_BENCHMARK_ROUNDS && after == before ? "ok" : "LEAK");
+}
@@ -0,0 +1,113 @@
+#include "clock.h"
+#include "asm_utils.h"
+#include "interrupt.h"
+#include "os_constant.h"
+#include "os_modules.h"
+#include "stdio.h"
+
+Clock::Clock()
+{
+}
+
+void Clock::initialize(uint32 hz)
+{
+    divisor = PIT_FREQUENCY / hz;
+    if (divisor > 0xffff)
+    {
+        divisor = 0xffff;
+    }
+    else if (divisor < 1)
+    {
+        divisor = 1;
+    }
+
+    // 计数器0，先写低字节后写高字节，方式2（分频器）
+    asm_out_port(0x43, 0x34);
+    asm_out_port(0x40, divisor & 0xff);
+    asm_out_port(0x40, (divisor >> 8) & 0xff);
+
+    // 实际的周期为divisor / PIT_FREQUENCY秒
+    nsPerTick = asm_divide((uint64)divisor * 1000000000, PIT_FREQUENCY);
+
+    cyclesPerTick = asm_divide((uint64)calibrate() * divisor, TSC_CALIBRATE_COUNT);
+
+    // 时间戳计数器过慢时乘数超过32位，只使用时钟中断计时
+    if (cyclesPerTick <= (nsPerTick >> (32 - CLOCK_SHIFT)))
+    {
+        cyclesPerTick = 0;
+    }
+
+    mult = cyclesPerTick ? asm_divide((uint64)nsPerTick << CLOCK_SHIFT, cyclesPerTick) : 0;
+
+    lastCycles = asm_read_tsc();
+    lastNanoseconds = 0;
+
+    printf("clock\n"
+           "    HZ: %d, tick: %d ns\n"
+           "    TSC: %d cycles per tick\n",
+           hz, nsPerTick, cyclesPerTick);
+}
+
+uint32 Clock::calibrate()
+{
+    uint8 value;
+
+    // 打开计数器2的门控，关闭扬声器
+    asm_in_port(0x61, &value);
+    asm_out_port(0x61, (value & ~0x02) | 0x01);
+
+    // 计数器2，先写低字节后写高字节，方式0（计数结束时输出高电平）
+    asm_out_port(0x43, 0xb0);
+    asm_out_port(0x42, TSC_CALIBRATE_COUNT & 0xff);
+    asm_out_port(0x42, (TSC_CALIBRATE_COUNT >> 8) & 0xff);
+
+    uint64 start = asm_read_tsc();
+
+    // 计数器2的输出反映在0x61端口的第5位
+    do
+    {
+        asm_in_port(0x61, &value);
+    } while (!(value & 0x20));
+
+    uint64 end = asm_read_tsc();
+
+    return (uint32)(end - start);
+}
+
+void Clock::tick()
+{
+    if (!cyclesPerTick)
+    {
+        lastNanoseconds += nsPerTick;
+        return;
+    }
+
+    // 每次时钟中断都推进，两次推进间的增量较小，乘法不会溢出
+    uint64 cycles = asm_read_tsc();
+    lastNanoseconds += ((cycles - lastCycles) * mult) >> CLOCK_SHIFT;
+    lastCycles = cycles;
+}
+
+uint64 Clock::now()
+{
+    // 64位的变量不能原子地读写，关中断防止被时钟中断修改
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    uint64 time = lastNanoseconds;
+    if (cyclesPerTick)
+    {
+        time += ((asm_read_tsc() - lastCycles) * mult) >> CLOCK_SHIFT;
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return time;
+}
+
+void Clock::getTime(TimeSpec &time)
+{
+    uint64 nanoseconds = now();
+
+    time.seconds = asm_divide(nanoseconds, 1000000000);
+    time.nanoseconds = (uint32)(nanoseconds - (uint64)time.seconds * 1000000000);
+}
@@ -6,7 +6,7 @@
 #include "os_modules.h"
 #include "program.h"
 
-int times = 0;
+uint32 jiffies = 0;
 
 InterruptManager::InterruptManager()
 {
@@ -15,8 +15,8 @@ InterruptManager::InterruptManager()
 
 void InterruptManager::initialize()
 {
-    // 初始化中断计数变量
-    times = 0;
+    // 初始化时钟中断计数
+    jiffies = 0;
     
     // 初始化IDT
     IDT = (uint32 *)IDT_START_ADDRESS;
@@ -89,10 +89,22 @@ extern "C" void c_time_interrupt_handler()
 {
     PCB *cur = programManager.running;
 
-    if (cur->ticks)
+    ++jiffies;
+    systemClock.tick();
+    // 到期的定时器可能唤醒线程，需要在调度之前处理
+    timerManager.run();
+
+    // 空闲线程没有时间片，有线程就绪时立即让出处理器
+    if (cur == programManager.idle)
+    {
+        ++programManager.idleTicks;
+        programManager.schedule();
+    }
+    else if (cur->ticks)
     {
         --cur->ticks;
         ++cur->ticksPassedBy;
+        programManager.charge(cur);
     }
     else
     {
@@ -5,56 +5,129 @@
 #include "stdio.h"
 #include "program.h"
 #include "os_modules.h"
+#include "boot_info.h"
 
 MemoryManager::MemoryManager()
 {
     initialize();
 }
 
-void MemoryManager::initialize()
+void MemoryManager::initialize(enum PhysicalPoolBackend backend)
 {
+    this->backend = PhysicalPoolBackend::BITMAP_BACKEND;
+
+    MemoryRange ranges[E820_MAX_ENTRIES];
+    int ignoredMemory;
+    int rangeCount = getUsableMemory(ranges, ignoredMemory);
+
     this->totalMemory = 0;
-    this->totalMemory = getTotalMemory();
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        this->totalMemory += ranges[i].end - ranges[i].start;
+    }
 
     // 预留的内存
-    int usedMemory = 256 * PAGE_SIZE + 0x100000;
-    if (this->totalMemory < usedMemory)
+    uint32 usedMemory = 256 * PAGE_SIZE + 0x100000;
+
+    // 预留的内存之上的可用区域由物理地址池管理
+    int count = 0;
+    int freePages = 0;
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        if (ranges[i].end <= usedMemory)
+        {
+            continue;
+        }
+        if (ranges[i].start < usedMemory)
+        {
+            ranges[i].start = usedMemory;
+        }
+        ranges[count] = ranges[i];
+        freePages += (ranges[count].end - ranges[count].start) / PAGE_SIZE;
+        ++count;
+    }
+
+    if (freePages < 2)
     {
         printf("memory is too small, halt.\n");
         asm_halt();
     }
-    // 剩余的空闲的内存
-    int freeMemory = this->totalMemory - usedMemory;
 
-    int freePages = freeMemory / PAGE_SIZE;
+    // 内核物理地址池由前一半可用的页组成
     int kernelPages = freePages / 2;
-    int userPages = freePages - kernelPages;
-
+    uint32 kernelEnd = usedMemory;
+    for (int i = 0, pages = 0; i < count; ++i)
+    {
+        int length = (ranges[i].end - ranges[i].start) / PAGE_SIZE;
+        if (pages + length >= kernelPages)
+        {
+            kernelEnd = ranges[i].start + (kernelPages - pages) * PAGE_SIZE;
+            break;
+        }
+        pages += length;
+    }
+    // 两个物理地址池覆盖所有可用的区域，区域之间的空洞在位图中标记为已分配
     int kernelPhysicalStartAddress = usedMemory;
-    int userPhysicalStartAddress = usedMemory + kernelPages * PAGE_SIZE;
+    int userPhysicalStartAddress = kernelEnd;
+    int kernelSpan = (kernelEnd - usedMemory) / PAGE_SIZE;
+    int userSpan = (ranges[count - 1].end - kernelEnd) / PAGE_SIZE;
+
+    // 位图存放在内核物理地址池的第一个足够大的可用区域的开头，BitMap按32位字访问，每个位图占用的空间向上取整到4字节
+    int bitmapPages = ceil(ceil(kernelSpan, 32) * 4 + ceil(userSpan, 32) * 4 +
+                               ceil(KERNEL_VIRTUAL_PAGES, 32) * 4,
+                           PAGE_SIZE);
+    int bitmapAddress = 0;
+    for (int i = 0; i < count && ranges[i].start < kernelEnd; ++i)
+    {
+        uint32 end = ranges[i].end < kernelEnd ? ranges[i].end : kernelEnd;
+        if ((end - ranges[i].start) / PAGE_SIZE >= (uint32)bitmapPages)
+        {
+            bitmapAddress = ranges[i].start;
+            break;
+        }
+    }
+
+    if (!bitmapAddress)
+    {
+        printf("memory is too small, halt.\n");
+        asm_halt();
+    }
 
-    int kernelPhysicalBitMapStart = BITMAP_START_ADDRESS;
-    int userPhysicalBitMapStart = kernelPhysicalBitMapStart + ceil(kernelPages, 8);
-    int kernelVirtualBitMapStart = userPhysicalBitMapStart + ceil(userPages, 8);
+    int kernelPhysicalBitMapStart = phys2virt(bitmapAddress);
+    int userPhysicalBitMapStart = kernelPhysicalBitMapStart + ceil(kernelSpan, 32) * 4;
+    int kernelVirtualBitMapStart = userPhysicalBitMapStart + ceil(userSpan, 32) * 4;
 
     kernelPhysical.initialize(
         (char *)kernelPhysicalBitMapStart,
-        kernelPages,
+        kernelSpan,
         kernelPhysicalStartAddress);
 
     userPhysical.initialize(
         (char *)userPhysicalBitMapStart,
-        userPages,
+        userSpan,
         userPhysicalStartAddress);
 
     kernelVirtual.initialize(
         (char *)kernelVirtualBitMapStart,
-        kernelPages,
+        KERNEL_VIRTUAL_PAGES,
         KERNEL_VIRTUAL_START);
 
-    printf("total memory: %d bytes ( %d MB )\n",
+    kernelPages = kernelSpan - reserveHoles(kernelPhysical, ranges, count);
+    int userPages = userSpan - reserveHoles(userPhysical, ranges, count);
+    kernelPhysical.reserve(bitmapAddress, bitmapPages);
+
+    printf("total memory: %d bytes ( %d MB ), %d usable ranges\n",
            this->totalMemory,
-           this->totalMemory / 1024 / 1024);
+           this->totalMemory / 1024 / 1024,
+           rangeCount);
+
+    // 每个物理页都需要在直接映射区中有固定的虚拟地址
+    if (ignoredMemory)
+    {
+        printf("note: only memory below %d MB is managed, %d MB above it is ignored\n",
+               MAX_PHYSICAL_ADDRESS / 1024 / 1024,
+               ignoredMemory);
+    }
 
     printf("kernel pool\n"
            "    start address: 0x%x\n"
@@ -77,58 +150,340 @@ void MemoryManager::initialize()
            "    total pages: %d  ( %d MB ) \n"
            "    bit map start address: 0x%x\n",
            KERNEL_VIRTUAL_START,
-           userPages, kernelPages * PAGE_SIZE / 1024 / 1024,
+           KERNEL_VIRTUAL_PAGES, KERNEL_VIRTUAL_PAGES * PAGE_SIZE / 1024 / 1024,
            kernelVirtualBitMapStart);
+
+    // 用户物理页的引用计数和反向映射
+    // 按用户物理地址池的页号索引，包括空洞
+    userFrameReferences = (uint8 *)allocatePages(AddressPoolType::KERNEL, ceil(userSpan, PAGE_SIZE));
+    userFrameMappings = (FrameMapping *)allocatePages(AddressPoolType::KERNEL,
+                                                      ceil(userSpan * sizeof(FrameMapping), PAGE_SIZE));
+    if (!userFrameReferences || !userFrameMappings)
+    {
+        printf("memory is too small, halt.\n");
+        asm_halt();
+    }
+    memset(userFrameReferences, 0, userSpan);
+    memset(userFrameMappings, 0, userSpan * sizeof(FrameMapping));
+
+    // 预先清零的页由后台线程补充，初始时为空
+    kernelZeroPages.initialize(AddressPoolType::KERNEL);
+    userZeroPages.initialize(AddressPoolType::USER);
+    zeroPageDemand.initialize(0);
+    zeroThreadWaiting = false;
+
+    allocateLatency.initialize();
+    releaseLatency.initialize();
+
+    // 缺页中断
+    interruptManager.setInterruptDescriptor(14, (uint32)asm_page_fault_handler, 0);
+
+    if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+    {
+        // 伙伴系统的页信息存放在内核空间中，此时仍使用位图分配
+        int kernelMetadata = allocatePages(AddressPoolType::KERNEL,
+                                           ceil(BuddyAllocator::metadataSize(kernelSpan), PAGE_SIZE));
+        int userMetadata = allocatePages(AddressPoolType::KERNEL,
+                                         ceil(BuddyAllocator::metadataSize(userSpan), PAGE_SIZE));
+
+        if (!kernelMetadata || !userMetadata)
+        {
+            printf("can not allocate buddy metadata, use bitmap\n");
+            return;
+        }
+
+        initializeBuddy(kernelBuddy, kernelPhysical, kernelMetadata);
+        initializeBuddy(userBuddy, userPhysical, userMetadata);
+        this->backend = backend;
+    }
+
+    printf("physical pool backend: %s\n",
+           this->backend == PhysicalPoolBackend::BUDDY_BACKEND ? "buddy" : "bitmap");
 }
 
-int MemoryManager::allocatePhysicalPages(enum AddressPoolType type, const int count)
+void MemoryManager::initializeBuddy(BuddyAllocator &buddy, AddressPool &pool, const int metadata)
+{
+    int length = pool.resources.size();
+    int index, start;
+
+    buddy.initialize((char *)metadata, length, pool.startAddress);
+
+    // 位图中空闲的页交给伙伴系统管理
+    index = 0;
+    while (index < length)
+    {
+        if (pool.resources.get(index))
+        {
+            ++index;
+            continue;
+        }
+
+        start = index;
+        while (index < length && !pool.resources.get(index))
+        {
+            ++index;
+        }
+
+        buddy.release(pool.startAddress + start * PAGE_SIZE, index - start);
+    }
+
+    // 初始化时放入的空闲页不计入释放次数
+    buddy.releases = 0;
+}
+
+int MemoryManager::allocatePhysicalPages(enum AddressPoolType type, const int count, const bool reclaim)
 {
     int start = -1;
 
     if (type == AddressPoolType::KERNEL)
     {
-        start = kernelPhysical.allocate(count);
+        if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+            start = kernelBuddy.allocate(count);
+        else
+            start = kernelPhysical.allocate(count);
+
+        // 物理页耗尽时使用预先清零的页
+        if (start == -1 && count == 1 && reclaim)
+        {
+            int page = kernelZeroPages.allocate();
+            if (page)
+            {
+                start = page;
+            }
+        }
     }
     else if (type == AddressPoolType::USER)
     {
-        start = userPhysical.allocate(count);
+        if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+            start = userBuddy.allocate(count);
+        else
+            start = userPhysical.allocate(count);
+
+        // 物理页耗尽时先使用预先清零的页，再换出一页后重试
+        if (start == -1 && count == 1 && reclaim)
+        {
+            int page = userZeroPages.allocate();
+            if (page)
+            {
+                start = page;
+            }
+            else if (swapManager.swapOut())
+            {
+                if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+                    start = userBuddy.allocate(1);
+                else
+                    start = userPhysical.allocate(1);
+            }
+        }
+
+        if (start != -1)
+        {
+            int index = (start - userPhysical.startAddress) / PAGE_SIZE;
+            for (int i = 0; i < count; ++i)
+            {
+                userFrameReferences[index + i] = 1;
+            }
+        }
     }
 
     return (start == -1) ? 0 : start;
 }
 
-void MemoryManager::releasePhysicalPages(enum AddressPoolType type, const int paddr, const int count)
+void MemoryManager::releasePhysicalPages(enum AddressPoolType type, const int paddr, const int count, PCB *owner)
 {
     if (type == AddressPoolType::KERNEL)
     {
-        kernelPhysical.release(paddr, count);
+        if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+            kernelBuddy.release(paddr, count);
+        else
+            kernelPhysical.release(paddr, count);
     }
     else if (type == AddressPoolType::USER)
     {
+        // 引用计数减为0的物理页才被释放，连续的页一起释放
+        int index = (paddr - userPhysical.startAddress) / PAGE_SIZE;
+        int start = -1;
+        bool unused;
 
-        userPhysical.release(paddr, count);
+        if (!owner)
+        {
+            owner = programManager.running;
+        }
+
+        for (int i = 0; i <= count; ++i)
+        {
+            unused = false;
+            if (i < count && userFrameReferences[index + i])
+            {
+                // 释放者不再映射该页，其反向映射随之失效
+                if (userFrameMappings[index + i].owner == owner)
+                {
+                    userFrameMappings[index + i].owner = nullptr;
+                }
+                unused = !(--userFrameReferences[index + i]);
+            }
+
+            if (unused)
+            {
+                userFrameMappings[index + i].owner = nullptr;
+                if (start == -1)
+                    start = i;
+            }
+            else if (start != -1)
+            {
+                if (backend == PhysicalPoolBackend::BUDDY_BACKEND)
+                    userBuddy.release(paddr + start * PAGE_SIZE, i - start);
+                else
+                    userPhysical.release(paddr + start * PAGE_SIZE, i - start);
+                start = -1;
+            }
+        }
     }
 }
 
 int MemoryManager::getTotalMemory()
 {
+    return this->totalMemory;
+}
+
+int MemoryManager::getUsableMemory(MemoryRange *ranges, int &ignored)
+{
+    BootInfo *info = (BootInfo *)BOOT_INFO_ADDRESS;
+    int count = 0;
+    // 超出MAX_PHYSICAL_ADDRESS的可用内存的字节数
+    uint64 beyond = 0;
+
+    for (uint32 i = 0; i < info->e820Count && i < E820_MAX_ENTRIES; ++i)
+    {
+        E820Entry *entry = &info->e820[i];
+        if (entry->type != E820_USABLE)
+        {
+            continue;
+        }
+
+        uint64 base = ((uint64)entry->baseHigh << 32) | entry->baseLow;
+        uint64 top = base + (((uint64)entry->lengthHigh << 32) | entry->lengthLow);
+        if (top > MAX_PHYSICAL_ADDRESS)
+        {
+            beyond += top - (base > MAX_PHYSICAL_ADDRESS ? base : MAX_PHYSICAL_ADDRESS);
+        }
+        if (base >= MAX_PHYSICAL_ADDRESS)
+        {
+            continue;
+        }
+
+        uint32 end = top > MAX_PHYSICAL_ADDRESS ? MAX_PHYSICAL_ADDRESS : (uint32)top;
+
+        // 不足一页的部分不使用
+        uint32 start = (entry->baseLow + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        end &= ~(PAGE_SIZE - 1);
+        if (start >= end)
+        {
+            continue;
+        }
+
+        // BIOS返回的区域不一定有序，按起始地址插入
+        int j = count;
+        while (j > 0 && ranges[j - 1].start > start)
+        {
+            ranges[j] = ranges[j - 1];
+            --j;
+        }
+        ranges[j].start = start;
+        ranges[j].end = end;
+        ++count;
+    }
 
-    if (!this->totalMemory)
+    if (!count)
     {
+        // E801h返回的是1MB以上的内存容量，视为一个连续的区域
         int memory = *((int *)MEMORY_SIZE_ADDRESS);
         // ax寄存器保存的内容
-        int low = memory & 0xffff;
+        uint32 low = memory & 0xffff;
         // bx寄存器保存的内容
-        int high = (memory >> 16) & 0xffff;
+        uint32 high = (memory >> 16) & 0xffff;
 
-        this->totalMemory = low * 1024 + high * 64 * 1024;
+        uint64 top = 0x100000 + (uint64)low * 1024 + (uint64)high * 64 * 1024;
+        ranges[0].start = 0x100000;
+        ranges[0].end = top > MAX_PHYSICAL_ADDRESS ? MAX_PHYSICAL_ADDRESS : (uint32)top;
+        ignored = top > MAX_PHYSICAL_ADDRESS ? (top - MAX_PHYSICAL_ADDRESS) >> 20 : 0;
+        return 1;
     }
 
-    return this->totalMemory;
+    // 合并重叠或相邻的区域
+    int merged = 1;
+    for (int i = 1; i < count; ++i)
+    {
+        if (ranges[i].start <= ranges[merged - 1].end)
+        {
+            if (ranges[i].end > ranges[merged - 1].end)
+            {
+                ranges[merged - 1].end = ranges[i].end;
+            }
+        }
+        else
+        {
+            ranges[merged] = ranges[i];
+            ++merged;
+        }
+    }
+
+    ignored = beyond >> 20;
+    return merged;
+}
+
+int MemoryManager::reserveHoles(AddressPool &pool, const MemoryRange *ranges, const int count)
+{
+    uint32 address = pool.startAddress;
+    uint32 end = address + pool.resources.size() * PAGE_SIZE;
+    int holes = 0;
+
+    for (int i = 0; i < count && address < end; ++i)
+    {
+        if (ranges[i].end <= address)
+        {
+            continue;
+        }
+
+        if (ranges[i].start > address)
+        {
+            uint32 holeEnd = ranges[i].start < end ? ranges[i].start : end;
+            pool.reserve(address, (holeEnd - address) / PAGE_SIZE);
+            holes += (holeEnd - address) / PAGE_SIZE;
+        }
+        address = ranges[i].end;
+    }
+
+    if (address < end)
+    {
+        pool.reserve(address, (end - address) / PAGE_SIZE);
+        holes += (end - address) / PAGE_SIZE;
+    }
+
+    return holes;
 }
 
 int MemoryManager::allocatePages(enum AddressPoolType type, const int count)
 {
+    uint64 start = asm_read_tsc();
+    int address = doAllocatePages(type, count);
+    allocateLatency.record(asm_read_tsc() - start);
+
+    return address;
+}
+
+int MemoryManager::doAllocatePages(enum AddressPoolType type, const int count)
+{
+    // 内核页优先从直接映射区分配，连续的物理页不需要建立页表项
+    if (type == AddressPoolType::KERNEL)
+    {
+        int physicalAddress = allocatePhysicalPages(type, count);
+        if (physicalAddress)
+        {
+            return phys2virt(physicalAddress);
+        }
+    }
+
     // 第一步：从虚拟地址池中分配若干虚拟页
     int virtualAddress = allocateVirtualPages(type, count);
     if (!virtualAddress)
@@ -136,39 +491,58 @@ int MemoryManager::allocatePages(enum AddressPoolType type, const int count)
         return 0;
     }
 
-    bool flag;
+    // 用户页按需分配，物理页在缺页时分配
+    if (type == AddressPoolType::USER)
+    {
+        programManager.running->lazyPages += count;
+        return virtualAddress;
+    }
+
     int physicalPageAddress;
-    int vaddress = virtualAddress;
+    int mapped = 0;
+    int amount = count;
+    int connected;
 
-    // 依次为每一个虚拟页指定物理页
-    for (int i = 0; i < count; ++i, vaddress += PAGE_SIZE)
+    while (mapped < count)
     {
-        flag = false;
-        // 第二步：从物理地址池中分配一个物理页
-        physicalPageAddress = allocatePhysicalPages(type, 1);
-        if (physicalPageAddress)
+        // 第二步：从物理地址池中分配尽可能多的连续物理页，分配失败时将请求的页数减半
+        if (amount > count - mapped)
         {
-            //printf("allocate physical page 0x%x\n", physicalPageAddress);
-
-            // 第三步：为虚拟页建立页目录项和页表项，使虚拟页内的地址经过分页机制变换到物理页内。
-            flag = connectPhysicalVirtualPage(vaddress, physicalPageAddress);
+            amount = count - mapped;
         }
-        else
+
+        physicalPageAddress = allocatePhysicalPages(type, amount);
+        if (!physicalPageAddress)
         {
-            flag = false;
+            if (amount == 1)
+            {
+                break;
+            }
+            amount /= 2;
+            continue;
         }
 
-        // 分配失败，释放前面已经分配的虚拟页和物理页表
-        if (!flag)
+        // 第三步：为这一段虚拟页建立页目录项和页表项，使虚拟页内的地址经过分页机制变换到物理页内。
+        connected = connectPhysicalVirtualPages(virtualAddress + mapped * PAGE_SIZE, physicalPageAddress, amount);
+        mapped += connected;
+
+        if (connected < amount)
         {
-            // 前i个页表已经指定了物理页
-            releasePages(type, virtualAddress, i);
-            // 剩余的页表未指定物理页
-            releaseVirtualPages(type, virtualAddress + i * PAGE_SIZE, count - i);
-            return 0;
+            releasePhysicalPages(type, physicalPageAddress + connected * PAGE_SIZE, amount - connected);
+            break;
         }
     }
 
+    // 分配失败，释放前面已经分配的虚拟页和物理页
+    if (mapped < count)
+    {
+        // 前mapped个页表已经指定了物理页
+        releasePages(type, virtualAddress, mapped);
+        // 剩余的页表未指定物理页
+        releaseVirtualPages(type, virtualAddress + mapped * PAGE_SIZE, count - mapped);
+        return 0;
+    }
+
     return virtualAddress;
 }
 
@@ -190,29 +564,65 @@ int MemoryManager::allocateVirtualPages(enum AddressPoolType type, const int cou
 
 bool MemoryManager::connectPhysicalVirtualPage(const int virtualAddress, const int physicalPageAddress)
 {
-    // 计算虚拟地址对应的页目录项和页表项
-    int *pde = (int *)toPDE(virtualAddress);
-    int *pte = (int *)toPTE(virtualAddress);
+    return connectPhysicalVirtualPages(virtualAddress, physicalPageAddress, 1) == 1;
+}
+
+int MemoryManager::connectPhysicalVirtualPages(const int virtualAddress, const int physicalAddress, const int count)
+{
+    int vaddr = virtualAddress;
+    int paddr = physicalAddress;
+    int connected = 0;
+    int amount;
+    int *pde, *pte;
+    TLBFlushBatch batch;
+    // 内核空间的页是全局页
+    int flags = ((uint32)vaddr < KERNEL_DIRECT_MAP_START) ? 0x7 : (PAGE_GLOBAL | 0x7);
 
-    // 页目录项无对应的页表，先分配一个页表
-    if (!(*pde & 0x00000001))
+    while (connected < count)
     {
-        // 从内核物理地址空间中分配一个页表
-        int page = allocatePhysicalPages(AddressPoolType::KERNEL, 1);
-        if (!page)
-            return false;
+        // 计算虚拟地址对应的页目录项和页表项
+        pde = (int *)toPDE(vaddr);
+        pte = (int *)toPTE(vaddr);
 
-        // 使页目录项指向页表
-        *pde = page | 0x7;
-        // 初始化页表
-        char *pagePtr = (char *)(((int)pte) & 0xfffff000);
-        memset(pagePtr, 0, PAGE_SIZE);
-    }
+        // 页目录项无对应的页表，先分配一个页表
+        if (!(*pde & 0x00000001))
+        {
+            // 页表从内核物理地址池中分配，fork和回收进程时可以通过直接映射区访问，初始时所有页表项为0
+            int page = allocateZeroedPage(AddressPoolType::KERNEL);
+            if (!page)
+            {
+                batch.flush();
+                return connected;
+            }
 
-    // 使页表项指向物理页
-    *pte = physicalPageAddress | 0x7;
+            // 使页目录项指向页表
+            *pde = page | 0x7;
+        }
 
-    return true;
+        // 同一个页表中连续的页表项，不必重新计算和检查页目录项
+        amount = 1024 - ((vaddr >> 12) & 0x3ff);
+        if (amount > count - connected)
+        {
+            amount = count - connected;
+        }
+
+        // 使页表项指向物理页，重新映射已存在的页时，旧的TLB项需要失效
+        for (int i = 0; i < amount; ++i)
+        {
+            if (pte[i] & 0x1)
+            {
+                batch.add(vaddr + i * PAGE_SIZE);
+            }
+            pte[i] = (paddr + i * PAGE_SIZE) | flags;
+        }
+
+        connected += amount;
+        vaddr += amount * PAGE_SIZE;
+        paddr += amount * PAGE_SIZE;
+    }
+
+    batch.flush();
+    return connected;
 }
 
 int MemoryManager::toPDE(const int virtualAddress)
@@ -226,31 +636,102 @@ int MemoryManager::toPTE(const int virtualAddress)
 }
 
 void MemoryManager::releasePages(enum AddressPoolType type, const int virtualAddress, const int count)
+{
+    uint64 start = asm_read_tsc();
+    doReleasePages(type, virtualAddress, count);
+    releaseLatency.record(asm_read_tsc() - start);
+}
+
+void MemoryManager::doReleasePages(enum AddressPoolType type, const int virtualAddress, const int count)
+{
+    // 直接映射区的内核页只需释放物理页
+    if (isDirectMapped(virtualAddress))
+    {
+        releasePhysicalPages(type, virt2phys(virtualAddress), count);
+        return;
+    }
+
+    // 第一步，对每一个虚拟页，释放为其分配的物理页
+    unmapPages(type, virtualAddress, count);
+
+    // 第二步，释放虚拟页
+    releaseVirtualPages(type, virtualAddress, count);
+}
+
+void MemoryManager::unmapPages(enum AddressPoolType type, const int virtualAddress, const int count)
 {
     int vaddr = virtualAddress;
     int *pte;
+    int paddr;
+    // 物理地址连续的一段页，一起归还给物理地址池
+    int start = 0;
+    int amount = 0;
+    TLBFlushBatch batch;
+
     for (int i = 0; i < count; ++i, vaddr += PAGE_SIZE)
     {
-        // 第一步，对每一个虚拟页，释放为其分配的物理页
-        releasePhysicalPages(type, vaddr2paddr(vaddr), 1);
+        paddr = 0;
 
-        // 设置页表项为不存在，防止释放后被再次使用
-        pte = (int *)toPTE(vaddr);
-        *pte = 0;
+        // 按需分配的页可能从未被访问，没有对应的页表或物理页
+        if (*((int *)toPDE(vaddr)) & 0x1)
+        {
+            pte = (int *)toPTE(vaddr);
+            if (*pte & 0x1)
+            {
+                paddr = (*pte) & 0xfffff000;
+                // 设置页表项为不存在，防止释放后被再次使用
+                *pte = 0;
+                batch.add(vaddr);
+            }
+            else if (*pte & PAGE_SWAPPED)
+            {
+                // 已换出的页释放其页槽
+                swapManager.release(*pte);
+                *pte = 0;
+            }
+        }
+
+        if (amount && paddr == start + amount * PAGE_SIZE)
+        {
+            ++amount;
+            continue;
+        }
+
+        if (amount)
+        {
+            releasePhysicalPages(type, start, amount);
+        }
+
+        start = paddr;
+        amount = paddr ? 1 : 0;
     }
 
-    // 第二步，释放虚拟页
-    releaseVirtualPages(type, virtualAddress, count);
+    if (amount)
+    {
+        releasePhysicalPages(type, start, amount);
+    }
+
+    batch.flush();
 }
 
 int MemoryManager::vaddr2paddr(int vaddr)
 {
+    if (isDirectMapped(vaddr))
+    {
+        return virt2phys(vaddr);
+    }
+
     int *pte = (int *)toPTE(vaddr);
     int page = (*pte) & 0xfffff000;
     int offset = vaddr & 0xfff;
     return (page + offset);
 }
 
+bool MemoryManager::isDirectMapped(const int vaddr)
+{
+    return (uint32)vaddr >= KERNEL_DIRECT_MAP_START && (uint32)vaddr < KERNEL_VIRTUAL_START;
+}
+
 void MemoryManager::releaseVirtualPages(enum AddressPoolType type, const int vaddr, const int count)
 {
     if (type == AddressPoolType::KERNEL)
@@ -261,4 +742,426 @@ void MemoryManager::releaseVirtualPages(enum AddressPoolType type, const int vad
     {
         programManager.running->userVirtual.release(vaddr, count);
     }
-}
\ No newline at end of file
+}
+
+void MemoryManager::addFrameReference(const int paddr)
+{
+    ++userFrameReferences[(paddr - userPhysical.startAddress) / PAGE_SIZE];
+}
+
+int MemoryManager::getFrameReference(const int paddr)
+{
+    return userFrameReferences[(paddr - userPhysical.startAddress) / PAGE_SIZE];
+}
+
+bool MemoryManager::copyOnWrite(const int address)
+{
+    int vaddr = address & 0xfffff000;
+    int *pde = (int *)toPDE(vaddr);
+    int *pte = (int *)toPTE(vaddr);
+
+    // 写时复制的页只存在于用户空间，内核的直接映射区没有页表
+    if ((uint32)vaddr >= KERNEL_DIRECT_MAP_START || !(*pde & 0x1) || !(*pte & 0x1) || !(*pte & PAGE_COW))
+    {
+        return false;
+    }
+
+    int frame = (*pte) & 0xfffff000;
+    int flags = ((*pte) & 0xfff & ~PAGE_COW) | 0x2;
+
+    if (getFrameReference(frame) == 1)
+    {
+        // 物理页已不再被共享，恢复写权限即可
+        *pte = frame | flags;
+        setFrameMapping(frame, programManager.running, vaddr);
+        invalidatePage(vaddr);
+        return true;
+    }
+
+    int paddr = allocatePhysicalPages(AddressPoolType::USER, 1);
+    if (!paddr)
+    {
+        return false;
+    }
+
+    // 通过直接映射区将共享页的内容复制到新的物理页，再令页表项指向新的物理页
+    pageCopy((void *)vaddr, (void *)phys2virt(paddr));
+    *pte = paddr | flags;
+    releasePhysicalPages(AddressPoolType::USER, frame, 1);
+    setFrameMapping(paddr, programManager.running, vaddr);
+    invalidatePage(vaddr);
+
+    return true;
+}
+
+bool MemoryManager::allocateOnDemand(const int address)
+{
+    PCB *process = programManager.running;
+    uint32 vaddr = address & 0xfffff000;
+
+    // 只处理用户进程的用户空间，地址按无符号数比较
+    if (!process->pageDirectoryAddress || vaddr < USER_VADDR_START || vaddr >= KERNEL_DIRECT_MAP_START)
+    {
+        return false;
+    }
+
+    // 虚拟页必须已经分配
+    VirtualArea *area = process->userVirtual.find(vaddr);
+    if (!area)
+    {
+        return false;
+    }
+
+    // 已换出的页由交换区换入
+    if ((*((int *)toPDE(vaddr)) & 0x1) && *((int *)toPTE(vaddr)))
+    {
+        return false;
+    }
+
+    // 堆中只有结束地址之前的页是有效的
+    if (area->type == VirtualAreaType::HEAP_AREA && vaddr >= (uint32)process->heapBreak)
+    {
+        return false;
+    }
+
+    int paddr = allocateZeroedPage(AddressPoolType::USER);
+    if (!paddr)
+    {
+        return false;
+    }
+
+    // 不存在的页表项不会被TLB缓存，建立映射后即可直接访问
+    if (!connectPhysicalVirtualPage(vaddr, paddr))
+    {
+        releasePhysicalPages(AddressPoolType::USER, paddr, 1);
+        return false;
+    }
+
+    setFrameMapping(paddr, process, vaddr);
+
+    return true;
+}
+
+void MemoryManager::setFrameMapping(const int paddr, PCB *owner, const int vaddr)
+{
+    FrameMapping &mapping = userFrameMappings[(paddr - userPhysical.startAddress) / PAGE_SIZE];
+    mapping.owner = owner;
+    mapping.vaddr = vaddr;
+}
+
+void MemoryManager::invalidatePage(const int vaddr)
+{
+    asm_invlpg(vaddr);
+}
+
+TLBFlushBatch::TLBFlushBatch()
+{
+    count = 0;
+    global = false;
+}
+
+void TLBFlushBatch::add(const int vaddr)
+{
+    if (count < TLB_FLUSH_THRESHOLD)
+    {
+        pages[count] = vaddr;
+    }
+    ++count;
+
+    if ((uint32)vaddr >= KERNEL_DIRECT_MAP_START)
+    {
+        global = true;
+    }
+}
+
+void TLBFlushBatch::flush()
+{
+    if (count > TLB_FLUSH_THRESHOLD)
+    {
+        // 逐页刷新的开销超过重新加载CR3
+        if (global)
+            asm_flush_tlb_global();
+        else
+            asm_flush_tlb();
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            asm_invlpg(pages[i]);
+        }
+    }
+
+    count = 0;
+    global = false;
+}
+
+int MemoryManager::allocateZeroedPage(enum AddressPoolType type)
+{
+    ZeroPagePool &pool = (type == AddressPoolType::KERNEL) ? kernelZeroPages : userZeroPages;
+
+    int paddr = pool.allocate();
+    if (paddr)
+    {
+        return paddr;
+    }
+
+    paddr = allocatePhysicalPages(type, 1);
+    if (paddr)
+    {
+        zeroPhysicalPage(paddr);
+    }
+
+    return paddr;
+}
+
+void MemoryManager::zeroPhysicalPage(const int paddr)
+{
+    pageZero((void *)phys2virt(paddr));
+}
+
+void MemoryManager::getStatistics(MemoryStatistics &statistics)
+{
+    bool buddy = backend == PhysicalPoolBackend::BUDDY_BACKEND;
+
+    getPoolStatistics(statistics.kernelPhysical, kernelPhysical, buddy ? &kernelBuddy : nullptr);
+    getPoolStatistics(statistics.userPhysical, userPhysical, buddy ? &userBuddy : nullptr);
+    getPoolStatistics(statistics.kernelVirtual, kernelVirtual, nullptr);
+    getZeroPoolStatistics(statistics.kernelZero, kernelZeroPages);
+    getZeroPoolStatistics(statistics.userZero, userZeroPages);
+
+    statistics.allocateLatency = allocateLatency;
+    statistics.releaseLatency = releaseLatency;
+
+    statistics.swapOuts = swapManager.swapOuts;
+    statistics.swapIns = swapManager.swapIns;
+
+    statistics.cacheAmount = slabAllocator.getStatistics(statistics.caches, MAX_SLAB_CACHES);
+}
+
+void MemoryManager::getZeroPoolStatistics(ZeroPoolStatistics &statistics, ZeroPagePool &pool)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    statistics.pages = pool.count;
+    statistics.hits = pool.hits;
+    statistics.misses = pool.misses;
+    statistics.refills = pool.refills;
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void MemoryManager::getPoolStatistics(PoolStatistics &statistics, AddressPool &pool, BuddyAllocator *buddy)
+{
+    statistics.totalPages = pool.resources.size();
+
+    if (buddy)
+    {
+        buddy->countFree(statistics.freePages, statistics.largestFree);
+        statistics.allocations = buddy->allocations;
+        statistics.failures = buddy->failures;
+        statistics.releases = buddy->releases;
+    }
+    else
+    {
+        pool.resources.countFree(statistics.freePages, statistics.largestFree);
+        statistics.allocations = pool.allocations;
+        statistics.failures = pool.failures;
+        statistics.releases = pool.releases;
+    }
+
+    // 最长的连续空闲页占空闲页的比例越小，碎片越多
+    if (statistics.freePages)
+    {
+        statistics.fragmentation = 100 - statistics.largestFree * 100 / statistics.freePages;
+    }
+    else
+    {
+        statistics.fragmentation = 0;
+    }
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+}
+
+void LatencyHistogram::initialize()
+{
+    for (int i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        buckets[i] = 0;
+    }
+    count = 0;
+    maximum = 0;
+}
+
+void LatencyHistogram::record(const uint64 cycles)
+{
+    uint32 low = (uint32)cycles;
+    int bucket = LATENCY_BUCKETS - 1;
+
+    if (cycles >> 32)
+    {
+        low = 0xffffffff;
+    }
+    else
+    {
+        // 最高位的序号即桶号
+        int order = 0;
+        while (low >> (order + 1))
+        {
+            ++order;
+        }
+        if (order < bucket)
+        {
+            bucket = order;
+        }
+    }
+
+    ++buckets[bucket];
+    ++count;
+    if (low > maximum)
+    {
+        maximum = low;
+    }
+}
+
+ZeroPagePool::ZeroPagePool()
+{
+}
+
+void ZeroPagePool::initialize(enum AddressPoolType type)
+{
+    this->type = type;
+    count = 0;
+    hits = 0;
+    misses = 0;
+    refills = 0;
+}
+
+int ZeroPagePool::allocate()
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int paddr = 0;
+    if (count)
+    {
+        paddr = frames[--count];
+        ++hits;
+    }
+    else
+    {
+        ++misses;
+    }
+
+    // 后台清零线程在等待且池中的页数低于低水位时才唤醒它补充，每次等待只唤醒一次
+    if (memoryManager.zeroThreadWaiting && count < ZERO_POOL_LOW_WATER)
+    {
+        memoryManager.zeroThreadWaiting = false;
+        memoryManager.zeroPageDemand.V();
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return paddr;
+}
+
+bool ZeroPagePool::refill()
+{
+    // 物理地址池没有锁保护，分配和释放时关中断
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    // 不为了补充池而使用池中的页或换出页
+    int paddr = 0;
+    if (count < ZERO_POOL_PAGES)
+    {
+        paddr = memoryManager.allocatePhysicalPages(type, 1, false);
+    }
+
+    interruptManager.setInterruptStatus(status);
+
+    if (!paddr)
+    {
+        return false;
+    }
+
+    // 通过直接映射区清零，可以被打断
+    memoryManager.zeroPhysicalPage(paddr);
+
+    interruptManager.disableInterrupt();
+
+    bool flag = count < ZERO_POOL_PAGES;
+    if (flag)
+    {
+        frames[count++] = paddr;
+        ++refills;
+    }
+    else
+    {
+        memoryManager.releasePhysicalPages(type, paddr, 1);
+    }
+
+    interruptManager.setInterruptStatus(status);
+
+    return flag;
+}
+
+// 后台清零线程，补充预先清零的页，无页可补充时阻塞到池中的页数低于低水位
+void zero_page_thread(void *arg)
+{
+    while (true)
+    {
+        bool kernel = memoryManager.kernelZeroPages.refill();
+        bool user = memoryManager.userZeroPages.refill();
+
+        if (!kernel && !user)
+        {
+            // 信号量在关中断时释放，这里同样关中断等待
+            interruptManager.disableInterrupt();
+            memoryManager.zeroThreadWaiting = true;
+            memoryManager.zeroPageDemand.P();
+            interruptManager.enableInterrupt();
+        }
+    }
+}
+
+// 缺页中断处理函数
+extern "C" void c_page_fault_handler(int error, int address, int eip)
+{
+    PCB *program = programManager.running;
+
+    // P=0，访问已换出的页引起的缺页
+    if (!(error & 0x1) && swapManager.swapIn(address))
+    {
+        ++program->swapFaults;
+        return;
+    }
+
+    // P=0，首次访问已分配的页引起的缺页
+    if (!(error & 0x1) && memoryManager.allocateOnDemand(address))
+    {
+        ++program->demandFaults;
+        return;
+    }
+
+    // P=1且W/R=1，写只读页引起的缺页
+    if ((error & 0x3) == 0x3 && memoryManager.copyOnWrite(address))
+    {
+        ++program->cowFaults;
+        return;
+    }
+
+    printf("page fault: address 0x%x, error 0x%x, eip 0x%x, pid %d\n",
+           address, error, eip, program->pid);
+
+    // U/S=1，用户态引起的缺页只终止当前进程
+    if (error & 0x4)
+    {
+        programManager.exit(-1);
+    }
+
+    printf("halt\n");
+    asm_halt();
+}
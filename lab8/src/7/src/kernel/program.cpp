@@ -18,17 +18,31 @@ ProgramManager::ProgramManager()
     initialize();
 }
 
-void ProgramManager::initialize()
+void ProgramManager::initialize(enum SchedulingPolicy policy)
 {
+    this->policy = policy;
     allPrograms.initialize();
     readyPrograms.initialize();
+    fairPrograms.initialize();
     running = nullptr;
+    idleTicks = 0;
+
+    reaperQueue.initialize();
+    reaperSemaphore.initialize(0);
+    reaperQueueDepth = 0;
+    maxReaperQueueDepth = 0;
+    reapedPrograms = 0;
+    reapedFrames = 0;
+    reapTicks = 0;
 
     for (int i = 0; i < MAX_PROGRAM_AMOUNT; ++i)
     {
         PCB_SET_STATUS[i] = false;
     }
 
+    // 空闲线程最先创建，pid为0
+    idle = createThread(idle_thread, nullptr, "idle", 0);
+
     // 初始化用户代码段、数据段和栈段
     int selector;
 
@@ -42,6 +56,9 @@ void ProgramManager::initialize()
     USER_STACK_SELECTOR = (selector << 3) | 0x3;
 
     initializeTSS();
+
+    printf("scheduling policy: %s\n",
+           this->policy == SchedulingPolicy::FAIR_POLICY ? "fair" : "round robin");
 }
 
 int ProgramManager::executeThread(ThreadFunction function, void *parameter, const char *name, int priority)
@@ -50,23 +67,54 @@ int ProgramManager::executeThread(ThreadFunction function, void *parameter, cons
     bool status = interruptManager.getInterruptStatus();
     interruptManager.disableInterrupt();
 
+    PCB *thread = createThread(function, parameter, name, priority);
+
+    if (!thread)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    allPrograms.push_back(&(thread->tagInAllList));
+    addReady(thread, true, false);
+
+    // 恢复中断
+    interruptManager.setInterruptStatus(status);
+
+    return thread->pid;
+}
+
+PCB *ProgramManager::createThread(ThreadFunction function, void *parameter, const char *name, int priority)
+{
     // 分配一页作为PCB
     PCB *thread = allocatePCB();
 
     if (!thread)
-        return -1;
+        return nullptr;
 
     // 初始化分配的页
     memset(thread, 0, PCB_SIZE);
+    // 内核线程和executeProcess创建的进程没有父进程，fork时再设置为父进程的pid
+    // 若保持为0，空闲线程会被当作父进程，进程退出后无人回收
+    thread->parentPid = -1;
 
     for (int i = 0; i < MAX_PROGRAM_NAME && name[i]; ++i)
     {
         thread->name[i] = name[i];
     }
 
+    if (priority < 0)
+    {
+        priority = 0;
+    }
+    else if (priority >= PRIORITY_LEVELS)
+    {
+        priority = PRIORITY_LEVELS - 1;
+    }
+
     thread->status = ProgramStatus::READY;
     thread->priority = priority;
-    thread->ticks = priority * 10;
+    thread->ticks = timeSlice(thread);
     thread->ticksPassedBy = 0;
     thread->pid = ((int)thread - (int)PCB_SET) / PCB_SIZE;
 
@@ -81,13 +129,7 @@ int ProgramManager::executeThread(ThreadFunction function, void *parameter, cons
     thread->stack[5] = (int)program_exit;
     thread->stack[6] = (int)parameter;
 
-    allPrograms.push_back(&(thread->tagInAllList));
-    readyPrograms.push_back(&(thread->tagInGeneralList));
-
-    // 恢复中断
-    interruptManager.setInterruptStatus(status);
-
-    return thread->pid;
+    return thread;
 }
 
 void ProgramManager::schedule()
@@ -95,33 +137,36 @@ void ProgramManager::schedule()
     bool status = interruptManager.getInterruptStatus();
     interruptManager.disableInterrupt();
 
-    if (readyPrograms.size() == 0)
+    // 没有就绪线程时，当前线程若仍可执行则继续执行，否则切换到空闲线程
+    if (!hasReady() && running->status == ProgramStatus::RUNNING)
     {
         interruptManager.setInterruptStatus(status);
         return;
     }
-    else
+
+    if (running == idle)
     {
-        //printf("amount of ready programs: %d\n", readyPrograms.size());
+        // 空闲线程不放入就绪队列
+        running->status = ProgramStatus::READY;
     }
-
-    if (running->status == ProgramStatus::RUNNING)
+    else if (running->status == ProgramStatus::RUNNING)
     {
         running->status = ProgramStatus::READY;
-        running->ticks = running->priority * 10;
-        readyPrograms.push_back(&(running->tagInGeneralList));
+        running->ticks = timeSlice(running);
+        addReady(running, false, false);
     }
-    else if (running->status == ProgramStatus::DEAD)
+    else if (running->status == ProgramStatus::DEAD && !running->pageDirectoryAddress)
     {
+        // 内核线程没有等待它的父进程，先从线程队列中删除再归还PCB，否则PCB被再次分配时队列会被破坏
+        // 用户进程的PCB由回收线程和wait中较晚的一方归还
+        allPrograms.erase(&(running->tagInAllList));
         releasePCB(running);
     }
 
-    ListItem *item = readyPrograms.front();
-    PCB *next = ListItem2PCB(item, tagInGeneralList);
+    PCB *next = hasReady() ? takeReady() : idle;
     PCB *cur = running;
     next->status = ProgramStatus::RUNNING;
     running = next;
-    readyPrograms.pop_front();
 
     //printf("schedule: %x %x\n", cur, next);
 
@@ -169,11 +214,158 @@ void ProgramManager::releasePCB(PCB *program)
     PCB_SET_STATUS[index] = false;
 }
 
+int ProgramManager::countPCB()
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int amount = 0;
+    for (int i = 0; i < MAX_PROGRAM_AMOUNT; ++i)
+    {
+        if (PCB_SET_STATUS[i])
+        {
+            ++amount;
+        }
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return amount;
+}
+
 void ProgramManager::MESA_WakeUp(PCB *program)
 {
+    // 定时器在时钟中断中唤醒线程，就绪队列需要关中断访问
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
     program->status = ProgramStatus::READY;
     //printf("wake up program, pid: %d\n", program->pid);
-    readyPrograms.push_front(&(program->tagInGeneralList));
+    addReady(program, false, true);
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void ProgramManager::addReady(PCB *program, const bool created, const bool wakeup)
+{
+    if (policy == SchedulingPolicy::FAIR_POLICY)
+    {
+        if (created || wakeup)
+            fairPrograms.place(program, wakeup);
+        else
+            fairPrograms.push(program);
+    }
+    else
+    {
+        // 被唤醒的线程在同一优先级中先执行
+        if (wakeup)
+            readyPrograms.push_front(program);
+        else
+            readyPrograms.push_back(program);
+    }
+}
+
+PCB *ProgramManager::takeReady()
+{
+    PCB *program;
+
+    if (policy == SchedulingPolicy::FAIR_POLICY)
+    {
+        // 虚拟运行时间最小的就绪线程
+        program = fairPrograms.front();
+        fairPrograms.pop_front();
+    }
+    else
+    {
+        // 优先级最高的就绪线程
+        program = readyPrograms.front();
+        readyPrograms.pop_front();
+    }
+
+    return program;
+}
+
+bool ProgramManager::hasReady()
+{
+    return policy == SchedulingPolicy::FAIR_POLICY ? !fairPrograms.empty() : !readyPrograms.empty();
+}
+
+int ProgramManager::timeSlice(PCB *program)
+{
+    // 公平调度的时间片固定，优先级只影响虚拟运行时间的增长速度
+    return policy == SchedulingPolicy::FAIR_POLICY ? FAIR_TIME_SLICE : program->priority * 10;
+}
+
+void ProgramManager::charge(PCB *program)
+{
+    if (policy == SchedulingPolicy::FAIR_POLICY)
+    {
+        fairPrograms.charge(program);
+    }
+}
+
+void ProgramManager::getStatistics(CPUStatistics &statistics)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    statistics.totalTicks = jiffies;
+    statistics.idleTicks = idleTicks;
+    statistics.reaperQueueDepth = reaperQueueDepth;
+    statistics.maxReaperQueueDepth = maxReaperQueueDepth;
+    statistics.reapedPrograms = reapedPrograms;
+    statistics.reapedFrames = reapedFrames;
+    statistics.reapTicks = reapTicks;
+
+    interruptManager.setInterruptStatus(status);
+}
+
+int ProgramManager::getProcessStatistics(ProcessStatistics *statistics, const int max)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int amount = 0;
+    PCB *program = allPrograms.first(&PCB::tagInAllList);
+
+    while (program && amount < max)
+    {
+        // 内核线程没有用户地址空间
+        if (program->pageDirectoryAddress)
+        {
+            ProcessStatistics &process = statistics[amount];
+            process.pid = program->pid;
+            strcpy(program->name, process.name);
+            process.status = program->status;
+            process.lazyPages = program->lazyPages;
+            process.demandFaults = program->demandFaults;
+            process.cowFaults = program->cowFaults;
+            process.swapFaults = program->swapFaults;
+            ++amount;
+        }
+
+        program = allPrograms.next(program, &PCB::tagInAllList);
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return amount;
+}
+
+void idle_thread(void *arg)
+{
+    while (true)
+    {
+        // 关中断后检查，避免检查后到达的中断唤醒的线程要等到下一次中断才执行
+        interruptManager.disableInterrupt();
+
+        if (programManager.hasReady())
+        {
+            programManager.schedule();
+        }
+        else
+        {
+            asm_idle();
+        }
+    }
 }
 
 void ProgramManager::initializeTSS()
@@ -203,17 +395,29 @@ int ProgramManager::executeProcess(const char *filename, int priority)
     bool status = interruptManager.getInterruptStatus();
     interruptManager.disableInterrupt();
 
-    // 在线程创建的基础上初步创建进程的PCB
-    int pid = executeThread((ThreadFunction)load_process,
-                            (void *)filename, filename, priority);
-    if (pid == -1)
+    PCB *process = createProcess(filename, priority);
+    if (!process)
     {
         interruptManager.setInterruptStatus(status);
         return -1;
     }
 
-    // 找到刚刚创建的PCB
-    PCB *process = ListItem2PCB(allPrograms.back(), tagInAllList);
+    allPrograms.push_back(&(process->tagInAllList));
+    addReady(process, true, false);
+
+    interruptManager.setInterruptStatus(status);
+
+    return process->pid;
+}
+
+PCB *ProgramManager::createProcess(const char *filename, int priority)
+{
+    // 在线程创建的基础上初步创建进程的PCB
+    PCB *process = createThread((ThreadFunction)load_process, (void *)filename, filename, priority);
+    if (!process)
+    {
+        return nullptr;
+    }
 
     // 创建进程的页目录表
     process->pageDirectoryAddress = createProcessPageDirectory();
@@ -221,37 +425,32 @@ int ProgramManager::executeProcess(const char *filename, int priority)
 
     if (!process->pageDirectoryAddress)
     {
-        process->status = ProgramStatus::DEAD;
-        interruptManager.setInterruptStatus(status);
-        return -1;
+        releasePCB(process);
+        return nullptr;
     }
 
-    // 创建进程的虚拟地址池
-    bool res = createUserVirtualPool(process);
-
-    if (!res)
+    // 创建进程的虚拟地址池，失败时页目录表和PCB由回收线程释放
+    if (!createUserVirtualPool(process))
     {
         process->status = ProgramStatus::DEAD;
-        interruptManager.setInterruptStatus(status);
-        return -1;
+        queueReap(process);
+        return nullptr;
     }
 
-    interruptManager.setInterruptStatus(status);
-
-    return pid;
+    return process;
 }
 
 int ProgramManager::createProcessPageDirectory()
 {
-    // 从内核地址池中分配一页存储用户进程的页目录表
-    int vaddr = memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
-    if (!vaddr)
+    // 从内核地址池中分配一个清零的页存储用户进程的页目录表，通过直接映射区访问
+    int paddr = memoryManager.allocateZeroedPage(AddressPoolType::KERNEL);
+    if (!paddr)
     {
         //printf("can not create page from kernel\n");
         return 0;
     }
 
-    memset((char *)vaddr, 0, PAGE_SIZE);
+    int vaddr = phys2virt(paddr);
 
     // 复制内核目录项到虚拟地址的高1GB
     int *src = (int *)(0xfffff000 + 0x300 * 4);
@@ -262,31 +461,18 @@ int ProgramManager::createProcessPageDirectory()
     }
 
     // 用户进程页目录表的最后一项指向用户进程页目录表本身
-    ((int *)vaddr)[1023] = memoryManager.vaddr2paddr(vaddr) | 0x7;
+    ((int *)vaddr)[1023] = paddr | 0x7;
 
     return vaddr;
 }
 
 bool ProgramManager::createUserVirtualPool(PCB *process)
 {
-    int sourcesCount = (0xc0000000 - USER_VADDR_START) / PAGE_SIZE;
-    int bitmapLength = ceil(sourcesCount, 8);
-
-    // 计算位图所占的页数
-    int pagesCount = ceil(bitmapLength, PAGE_SIZE);
-
-    int start = memoryManager.allocatePages(AddressPoolType::KERNEL, pagesCount);
-    //printf("%x %d\n", start, pagesCount);
-
-    if (!start)
-    {
-        return false;
-    }
-
-    memset((char *)start, 0, PAGE_SIZE * pagesCount);
-    (process->userVirtual).initialize((char *)start, sourcesCount, USER_VADDR_START);
+    // 用户虚拟地址空间只记录已分配的区域，初始时只有堆
+    (process->userVirtual).initialize(USER_VADDR_START, 0xc0000000);
 
-    return true;
+    // 预留用户进程堆的虚拟地址空间
+    return (process->userVirtual).reserve(USER_HEAP_START, USER_HEAP_PAGES, VirtualAreaType::HEAP_AREA);
 }
 
 void load_process(const char *filename)
@@ -335,6 +521,10 @@ void load_process(const char *filename)
 
     interruptStack->ss = programManager.USER_STACK_SELECTOR;
 
+    // 用户进程堆的第一页，用户态的内存分配器在其中存放管理信息，首次访问时被清零
+    process->heapBreak = USER_HEAP_START + PAGE_SIZE;
+    process->lazyPages += 1;
+
     asm_start_process((int)interruptStack);
 }
 
@@ -345,10 +535,14 @@ void ProgramManager::activateProgramPage(PCB *program)
     if (program->pageDirectoryAddress)
     {
         tss.esp0 = (int)program + PAGE_SIZE;
-        paddr = memoryManager.vaddr2paddr(program->pageDirectoryAddress);
+        paddr = virt2phys(program->pageDirectoryAddress);
     }
 
-    asm_update_cr3(paddr);
+    // 页目录表相同时不重新加载CR3，例如在两个内核线程之间切换
+    if (asm_read_cr3() != paddr)
+    {
+        asm_update_cr3(paddr);
+    }
 }
 
 int ProgramManager::fork()
@@ -364,25 +558,30 @@ int ProgramManager::fork()
         return -1;
     }
 
-    int pid = executeProcess("", 0);
-    if (pid == -1)
+    // 子进程与父进程位于同一优先级，复制完成后才放入线程队列和就绪队列
+    PCB *child = createProcess("", parent->priority);
+    if (!child)
     {
         interruptManager.setInterruptStatus(status);
         return -1;
     }
 
-    PCB *child = ListItem2PCB(this->allPrograms.back(), tagInAllList);
     bool flag = copyProcess(parent, child);
 
     if (!flag)
     {
+        // 子进程从未执行，已复制的页表由copyProcess撤销，其余部分由回收线程释放
         child->status = ProgramStatus::DEAD;
+        queueReap(child);
         interruptManager.setInterruptStatus(status);
         return -1;
     }
 
+    allPrograms.push_back(&(child->tagInAllList));
+    addReady(child, true, false);
+
     interruptManager.setInterruptStatus(status);
-    return pid;
+    return child->pid;
 }
 
 bool ProgramManager::copyProcess(PCB *parent, PCB *child)
@@ -407,33 +606,23 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
     child->priority = parent->priority;
     child->ticks = parent->ticks;
     child->ticksPassedBy = parent->ticksPassedBy;
+    child->heapBreak = parent->heapBreak;
     strcpy(parent->name, child->name);
 
-    // 复制用户虚拟地址池
-    int bitmapLength = parent->userVirtual.resources.length;
-    int bitmapBytes = ceil(bitmapLength, 8);
-    memcpy(parent->userVirtual.resources.bitmap, child->userVirtual.resources.bitmap, bitmapBytes);
-
-    char *buffer = (char *)memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
-    if (!buffer)
+    // 复制用户虚拟地址空间的区域，已复制的区域由回收线程释放
+    if (!child->userVirtual.copy(parent->userVirtual))
     {
-        child->status = ProgramStatus::DEAD;
         return false;
     }
 
-    // 子进程页目录表地址
-    int childPageDirPaddr = memoryManager.vaddr2paddr(child->pageDirectoryAddress);
-    // 父进程页目录表地址
-    int parentPageDirPaddr = memoryManager.vaddr2paddr(parent->pageDirectoryAddress);
     // 子进程页目录表指针(虚拟地址)
     int *childPageDir = (int *)child->pageDirectoryAddress;
     // 父进程页目录表指针(虚拟地址)
     int *parentPageDir = (int *)parent->pageDirectoryAddress;
 
-    //printf("%x %x\n", parent->pageDirectoryAddress, child->pageDirectoryAddress);
-
     memset((void *)child->pageDirectoryAddress, 0, 768 * 4);
 
+    // 写时复制，父子进程共享物理页，只为子进程复制页表
     for (int i = 0; i < 768; ++i)
     {
         // 无对应页表
@@ -442,11 +631,13 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
             continue;
         }
 
-        // 从用户物理地址池中分配一页，作为子进程的页目录项指向的页表
-        int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::USER, 1);
+        // 从内核物理地址池中分配一页，作为子进程的页目录项指向的页表
+        int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::KERNEL, 1);
         if (!paddr)
         {
-            child->status = ProgramStatus::DEAD;
+            releaseCopiedPageTables(child, i);
+            // 父进程的页表项已有一部分改为只读
+            asm_flush_tlb();
             return false;
         }
         // 页目录项
@@ -454,60 +645,70 @@ bool ProgramManager::copyProcess(PCB *parent, PCB *child)
         // 构造页表的起始虚拟地址
         int *pageTableVaddr = (int *)(0xffc00000 + (i << 12));
 
-        asm_update_cr3(childPageDirPaddr); // 进入子进程虚拟地址空间
+        for (int j = 0; j < 1024; ++j)
+        {
+            // 无对应物理页，已换出的页由父子进程共享页槽
+            if (!(pageTableVaddr[j] & 0x1))
+            {
+                if (pageTableVaddr[j] & PAGE_SWAPPED)
+                {
+                    swapManager.addReference(pageTableVaddr[j]);
+                }
+                continue;
+            }
 
-        childPageDir[i] = (pde & 0x00000fff) | paddr;
-        memset(pageTableVaddr, 0, PAGE_SIZE);
+            // 可写的页改为只读并标记为写时复制，写操作引发缺页时再复制，共享内存段的页仍由父子进程共享
+            if ((pageTableVaddr[j] & 0x2) && !(pageTableVaddr[j] & PAGE_SHARED))
+            {
+                pageTableVaddr[j] = (pageTableVaddr[j] & ~0x2) | PAGE_COW;
+            }
+
+            memoryManager.addFrameReference(pageTableVaddr[j] & 0xfffff000);
+        }
 
-        asm_update_cr3(parentPageDirPaddr); // 回到父进程虚拟地址空间
+        // 子进程的页表位于直接映射区，不必切换到子进程的地址空间
+        pageCopy(pageTableVaddr, (void *)phys2virt(paddr));
+        childPageDir[i] = (pde & 0x00000fff) | paddr;
     }
 
-    for (int i = 0; i < 768; ++i)
+    // 父进程的页表项改为只读，旧的TLB项需要失效
+    asm_flush_tlb();
+
+    return true;
+}
+
+void ProgramManager::releaseCopiedPageTables(PCB *child, const int end)
+{
+    int *childPageDir = (int *)child->pageDirectoryAddress;
+    int *pageTable;
+    int entry;
+
+    // 按与复制相反的顺序撤销，父进程仍引用这些页，引用计数不会减为0
+    // 父进程中改为写时复制的页在下次写入时发现引用计数为1，直接恢复写权限
+    for (int i = end - 1; i >= 0; --i)
     {
-        // 无对应页表
-        if (!(parentPageDir[i] & 0x1))
+        if (!(childPageDir[i] & 0x1))
         {
             continue;
         }
 
-        // 计算页表的虚拟地址
-        int *pageTableVaddr = (int *)(0xffc00000 + (i << 12));
-
-        // 复制物理页
-        for (int j = 0; j < 1024; ++j)
+        pageTable = (int *)phys2virt(childPageDir[i] & 0xfffff000);
+        for (int j = 1023; j >= 0; --j)
         {
-            // 无对应物理页
-            if (!(pageTableVaddr[j] & 0x1))
+            entry = pageTable[j];
+            if (entry & 0x1)
             {
-                continue;
+                memoryManager.releasePhysicalPages(AddressPoolType::USER, entry & 0xfffff000, 1, child);
             }
-
-            // 从用户物理地址池中分配一页，作为子进程的页表项指向的物理页
-            int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::USER, 1);
-            if (!paddr)
+            else if (entry & PAGE_SWAPPED)
             {
-                child->status = ProgramStatus::DEAD;
-                return false;
+                swapManager.release(entry);
             }
-
-            // 构造物理页的起始虚拟地址
-            void *pageVaddr = (void *)((i << 22) + (j << 12));
-            memcpy(pageVaddr, buffer, PAGE_SIZE);
-            // 页表项
-            int pte = pageTableVaddr[j];
-
-            asm_update_cr3(childPageDirPaddr); // 进入子进程虚拟地址空间
-
-            pageTableVaddr[j] = (pte & 0x00000fff) | paddr;
-            memcpy(buffer, pageVaddr, PAGE_SIZE);
-
-            asm_update_cr3(parentPageDirPaddr); // 回到父进程虚拟地址空间
         }
-    }
 
-    // 归还从内核分配的页表
-    memoryManager.releasePages(AddressPoolType::KERNEL, (int)buffer, 1);
-    return true;
+        memoryManager.releasePhysicalPages(AddressPoolType::KERNEL, childPageDir[i] & 0xfffff000, 1);
+        childPageDir[i] = 0;
+    }
 }
 
 void ProgramManager::exit(int ret)
@@ -518,64 +719,185 @@ void ProgramManager::exit(int ret)
     program->retValue = ret;
     program->status = ProgramStatus::DEAD;
 
-    int *pageDir, *page;
-    int paddr;
-
+    // 地址空间交给回收线程释放，当前进程立即让出处理器
     if (program->pageDirectoryAddress)
     {
-        pageDir = (int *)program->pageDirectoryAddress;
-        for (int i = 0; i < 768; ++i)
+        queueReap(program);
+    }
+
+    // 唤醒在wait中等待的父进程，同时处理子进程
+    bool found = false;
+    PCB *other = allPrograms.first(&PCB::tagInAllList);
+    while (other)
+    {
+        PCB *next = allPrograms.next(other, &PCB::tagInAllList);
+
+        if (other->parentPid == program->pid)
         {
-            if (!(pageDir[i] & 0x1))
+            // 不再有进程等待子进程，已退出的子进程直接删除，其余的子进程退出时删除自己
+            other->parentPid = -1;
+            if (other->status == ProgramStatus::DEAD)
             {
-                continue;
+                allPrograms.erase(&(other->tagInAllList));
+                if (!other->pageDirectoryAddress)
+                {
+                    releasePCB(other);
+                }
+            }
+        }
+        else if (other->pid == program->parentPid)
+        {
+            found = true;
+            if (other->status == ProgramStatus::WAITING)
+            {
+                MESA_WakeUp(other);
             }
+        }
+
+        other = next;
+    }
+
+    // 没有父进程的进程不会被wait删除，PCB在回收地址空间后归还
+    if (!found)
+    {
+        allPrograms.erase(&(program->tagInAllList));
+    }
 
-            page = (int *)(0xffc00000 + (i << 12));
+    schedule();
+}
+
+void ProgramManager::queueReap(PCB *program)
+{
+    reaperQueue.push_back(&(program->tagInGeneralList));
+    ++reaperQueueDepth;
+    if (reaperQueueDepth > maxReaperQueueDepth)
+    {
+        maxReaperQueueDepth = reaperQueueDepth;
+    }
+    reaperSemaphore.V();
+}
+
+void ProgramManager::reap(PCB *program)
+{
+    int *pageDir = (int *)program->pageDirectoryAddress;
+    int ticks = running->ticksPassedBy;
+    int *page;
+    int entry, paddr, start, amount;
+    bool status;
 
-            for (int j = 0; j < 1024; ++j)
+    for (int i = 0; i < 768; ++i)
+    {
+        if (!(pageDir[i] & 0x1))
+        {
+            continue;
+        }
+
+        // 每次释放一个页表中的页，释放完一个页表后可以被抢占
+        status = interruptManager.getInterruptStatus();
+        interruptManager.disableInterrupt();
+
+        // 回收线程不在program的地址空间中，页表通过直接映射区访问
+        page = (int *)phys2virt(pageDir[i] & 0xfffff000);
+
+        // 物理地址连续的一段页，一起归还给物理地址池
+        start = 0;
+        amount = 0;
+        for (int j = 0; j <= 1024; ++j)
+        {
+            paddr = 0;
+            if (j < 1024)
             {
-                if (!(page[j] & 0x1))
+                entry = page[j];
+                if (entry & 0x1)
+                {
+                    paddr = entry & 0xfffff000;
+                }
+                else if (entry & PAGE_SWAPPED)
                 {
-                    continue;
+                    swapManager.release(entry);
                 }
+            }
 
-                paddr = memoryManager.vaddr2paddr((i << 22) + (j << 12));
-                memoryManager.releasePhysicalPages(AddressPoolType::USER, paddr, 1);
+            if (amount && paddr == start + amount * PAGE_SIZE)
+            {
+                ++amount;
+                continue;
+            }
+
+            if (amount)
+            {
+                memoryManager.releasePhysicalPages(AddressPoolType::USER, start, amount, program);
+                reapedFrames += amount;
             }
 
-            paddr = memoryManager.vaddr2paddr((int)page);
-            memoryManager.releasePhysicalPages(AddressPoolType::USER, paddr, 1);
+            start = paddr;
+            amount = paddr ? 1 : 0;
         }
 
-        memoryManager.releasePages(AddressPoolType::KERNEL, (int)pageDir, 1);
+        memoryManager.releasePhysicalPages(AddressPoolType::KERNEL, pageDir[i] & 0xfffff000, 1);
+        pageDir[i] = 0;
 
-        int bitmapBytes = ceil(program->userVirtual.resources.length, 8);
-        int bitmapPages = ceil(bitmapBytes, PAGE_SIZE);
+        interruptManager.setInterruptStatus(status);
+    }
+
+    program->userVirtual.clear();
+
+    status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
 
-        memoryManager.releasePages(AddressPoolType::KERNEL, (int)program->userVirtual.resources.bitmap, bitmapPages);
+    // 只被该进程映射的共享内存段和该进程创建但从未映射的段随之释放
+    sharedMemoryManager.collect(program->pid);
+
+    memoryManager.releasePages(AddressPoolType::KERNEL, (int)pageDir, 1);
+    program->pageDirectoryAddress = 0;
+    // 已被wait从线程队列中删除的进程才能归还PCB，否则由wait归还
+    if (!program->tagInAllList.next)
+    {
+        releasePCB(program);
     }
 
-    schedule();
+    ++reapedPrograms;
+    reapTicks += running->ticksPassedBy - ticks;
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void reaper_thread(void *arg)
+{
+    PCB *program;
+
+    while (true)
+    {
+        // 信号量在exit中关中断时释放，这里同样关中断等待，避免自旋锁被持有时切换到exit
+        interruptManager.disableInterrupt();
+        programManager.reaperSemaphore.P();
+
+        program = container_of(programManager.reaperQueue.front(), &PCB::tagInGeneralList);
+        programManager.reaperQueue.pop_front();
+        --programManager.reaperQueueDepth;
+
+        interruptManager.enableInterrupt();
+
+        programManager.reap(program);
+    }
 }
 
 int ProgramManager::wait(int *retval)
 {
     PCB *child;
-    ListItem *item;
     bool interrupt, flag;
 
+    interrupt = interruptManager.getInterruptStatus();
+
     while (true)
     {
-        interrupt = interruptManager.getInterruptStatus();
         interruptManager.disableInterrupt();
 
-        item = this->allPrograms.head.next;
+        child = this->allPrograms.first(&PCB::tagInAllList);
 
         flag = true;
-        while (item)
+        while (child)
         {
-            child = ListItem2PCB(item, tagInAllList);
             if (child->parentPid == this->running->pid)
             {
                 flag = false;
@@ -584,10 +906,10 @@ int ProgramManager::wait(int *retval)
                     break;
                 }
             }
-            item = item->next;
+            child = this->allPrograms.next(child, &PCB::tagInAllList);
         }
 
-        if (item)
+        if (child)
         {
             if (retval)
             {
@@ -596,6 +918,11 @@ int ProgramManager::wait(int *retval)
 
             int pid = child->pid;
             this->allPrograms.erase(&(child->tagInAllList));
+            // 地址空间已被回收的进程归还PCB，否则由回收线程归还
+            if (!child->pageDirectoryAddress)
+            {
+                releasePCB(child);
+            }
             interruptManager.setInterruptStatus(interrupt);
             return pid;
         }
@@ -609,9 +936,55 @@ int ProgramManager::wait(int *retval)
             }
             else
             {
-                interruptManager.setInterruptStatus(interrupt);
+                // 阻塞到子进程退出时被唤醒
+                this->running->status = ProgramStatus::WAITING;
                 schedule();
             }
         }
     }
 }
+
+int ProgramManager::sbrk(int increment)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    PCB *process = this->running;
+    // 禁止内核线程调用
+    if (!process->pageDirectoryAddress)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    int oldBreak = process->heapBreak;
+    int newBreak = oldBreak + increment;
+
+    if (newBreak < USER_HEAP_START || newBreak > USER_HEAP_START + USER_HEAP_PAGES * PAGE_SIZE)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    // 堆中有效的页的结束地址
+    int oldTop = ceil(oldBreak, PAGE_SIZE) * PAGE_SIZE;
+    int newTop = ceil(newBreak, PAGE_SIZE) * PAGE_SIZE;
+
+    // 扩展堆时只移动结束地址，物理页在首次访问时分配
+    if (newTop > oldTop)
+    {
+        process->lazyPages += (newTop - oldTop) / PAGE_SIZE;
+    }
+
+    // 收缩堆，释放多余的物理页，虚拟页仍保留给堆使用
+    if (newTop < oldTop)
+    {
+        // unmapPages会使被释放的页的TLB项失效，防止继续访问已经释放的物理页
+        memoryManager.unmapPages(AddressPoolType::USER, newTop, (oldTop - newTop) / PAGE_SIZE);
+    }
+
+    process->heapBreak = newBreak;
+
+    interruptManager.setInterruptStatus(status);
+    return oldBreak;
+}
@@ -0,0 +1,277 @@
+#include "run_queue.h"
+
+PriorityRunQueue::PriorityRunQueue()
+{
+    initialize();
+}
+
+void PriorityRunQueue::initialize()
+{
+    for (int i = 0; i < PRIORITY_LEVELS; ++i)
+    {
+        queues[i].initialize();
+    }
+
+    bitmap = 0;
+    length = 0;
+}
+
+int PriorityRunQueue::size()
+{
+    return length;
+}
+
+bool PriorityRunQueue::empty()
+{
+    return length == 0;
+}
+
+void PriorityRunQueue::push_back(PCB *program)
+{
+    queues[program->priority].push_back(&(program->tagInGeneralList));
+    bitmap |= 1u << program->priority;
+    ++length;
+}
+
+void PriorityRunQueue::push_front(PCB *program)
+{
+    queues[program->priority].push_front(&(program->tagInGeneralList));
+    bitmap |= 1u << program->priority;
+    ++length;
+}
+
+PCB *PriorityRunQueue::front()
+{
+    if (!bitmap)
+    {
+        return nullptr;
+    }
+
+    return container_of(queues[highest()].front(), &PCB::tagInGeneralList);
+}
+
+void PriorityRunQueue::pop_front()
+{
+    if (!bitmap)
+    {
+        return;
+    }
+
+    int priority = highest();
+    queues[priority].pop_front();
+    if (queues[priority].empty())
+    {
+        bitmap &= ~(1u << priority);
+    }
+    --length;
+}
+
+int PriorityRunQueue::highest()
+{
+    // bsr指令，得到最高的1的位置
+    return 31 - __builtin_clz(bitmap);
+}
+
+FairRunQueue::FairRunQueue()
+{
+    initialize();
+}
+
+void FairRunQueue::initialize()
+{
+    root = nullptr;
+    leftmost = nullptr;
+    length = 0;
+    minVruntime = 0;
+    order = 0;
+}
+
+int FairRunQueue::size()
+{
+    return length;
+}
+
+bool FairRunQueue::empty()
+{
+    return length == 0;
+}
+
+void FairRunQueue::push(PCB *program)
+{
+    FairTreeNode &node = program->tagInFairTree;
+    node.left = nullptr;
+    node.right = nullptr;
+    node.height = 1;
+    node.order = order++;
+
+    root = insertNode(root, program);
+    if (!leftmost || less(program, leftmost))
+    {
+        leftmost = program;
+    }
+    ++length;
+}
+
+void FairRunQueue::place(PCB *program, const bool wakeup)
+{
+    updateMinimum(nullptr);
+
+    // 新线程从当前的最小值开始，不能因为虚拟运行时间为0而长时间独占处理器
+    // 睡眠的线程不能保留睡眠期间的积累，只得到少量补偿
+    if (!wakeup)
+    {
+        program->vruntime = minVruntime;
+    }
+    else if (before(program->vruntime, minVruntime - FAIR_WAKEUP_CREDIT))
+    {
+        program->vruntime = minVruntime - FAIR_WAKEUP_CREDIT;
+    }
+
+    push(program);
+}
+
+PCB *FairRunQueue::front()
+{
+    return leftmost;
+}
+
+void FairRunQueue::pop_front()
+{
+    if (!root)
+    {
+        return;
+    }
+
+    root = removeFirst(root);
+    --length;
+
+    leftmost = root;
+    while (leftmost && leftmost->tagInFairTree.left)
+    {
+        leftmost = leftmost->tagInFairTree.left;
+    }
+}
+
+void FairRunQueue::charge(PCB *program)
+{
+    program->vruntime += FAIR_WEIGHT_SCALE / (program->priority + 1);
+    updateMinimum(program);
+}
+
+bool FairRunQueue::before(const uint32 a, const uint32 b)
+{
+    return (int)(a - b) < 0;
+}
+
+bool FairRunQueue::less(PCB *a, PCB *b)
+{
+    if (a->vruntime != b->vruntime)
+    {
+        return before(a->vruntime, b->vruntime);
+    }
+
+    return before(a->tagInFairTree.order, b->tagInFairTree.order);
+}
+
+void FairRunQueue::updateMinimum(PCB *current)
+{
+    PCB *program = current;
+
+    if (leftmost && (!program || before(leftmost->vruntime, program->vruntime)))
+    {
+        program = leftmost;
+    }
+
+    if (program && before(minVruntime, program->vruntime))
+    {
+        minVruntime = program->vruntime;
+    }
+}
+
+PCB *FairRunQueue::insertNode(PCB *node, PCB *program)
+{
+    if (!node)
+    {
+        return program;
+    }
+
+    if (less(program, node))
+    {
+        node->tagInFairTree.left = insertNode(node->tagInFairTree.left, program);
+    }
+    else
+    {
+        node->tagInFairTree.right = insertNode(node->tagInFairTree.right, program);
+    }
+
+    return balance(node);
+}
+
+PCB *FairRunQueue::removeFirst(PCB *node)
+{
+    if (!node->tagInFairTree.left)
+    {
+        return node->tagInFairTree.right;
+    }
+
+    node->tagInFairTree.left = removeFirst(node->tagInFairTree.left);
+    return balance(node);
+}
+
+PCB *FairRunQueue::balance(PCB *node)
+{
+    FairTreeNode &tag = node->tagInFairTree;
+    int left = height(tag.left);
+    int right = height(tag.right);
+
+    tag.height = (left > right ? left : right) + 1;
+
+    if (left - right > 1)
+    {
+        FairTreeNode &child = tag.left->tagInFairTree;
+        if (height(child.left) < height(child.right))
+        {
+            tag.left = rotateLeft(tag.left);
+        }
+        return rotateRight(node);
+    }
+
+    if (right - left > 1)
+    {
+        FairTreeNode &child = tag.right->tagInFairTree;
+        if (height(child.right) < height(child.left))
+        {
+            tag.right = rotateRight(tag.right);
+        }
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+PCB *FairRunQueue::rotateLeft(PCB *node)
+{
+    PCB *right = node->tagInFairTree.right;
+
+    node->tagInFairTree.right = right->tagInFairTree.left;
+    right->tagInFairTree.left = node;
+
+    balance(node);
+    return balance(right);
+}
+
+PCB *FairRunQueue::rotateRight(PCB *node)
+{
+    PCB *left = node->tagInFairTree.left;
+
+    node->tagInFairTree.left = left->tagInFairTree.right;
+    left->tagInFairTree.right = node;
+
+    balance(node);
+    return balance(left);
+}
+
+int FairRunQueue::height(PCB *node)
+{
+    return node ? node->tagInFairTree.height : 0;
+}
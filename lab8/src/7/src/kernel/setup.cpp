@@ -8,6 +8,12 @@
 #include "syscall.h"
 #include "tss.h"
 #include "shell.h"
+#include "slab.h"
+#include "swap.h"
+#include "shm.h"
+#include "clock.h"
+#include "timer.h"
+#include "vma.h"
 
 // 屏幕IO处理器
 STDIO stdio;
@@ -21,6 +27,18 @@ MemoryManager memoryManager;
 SystemService systemService;
 // Task State Segment
 TSS tss;
+// 内核对象分配器
+SlabAllocator slabAllocator;
+// 交换区管理器
+SwapManager swapManager;
+// 共享内存管理器
+SharedMemoryManager sharedMemoryManager;
+// 时钟
+Clock systemClock;
+// 定时器管理器
+TimerManager timerManager;
+// 虚拟内存区域的cache
+ObjectCache<VirtualArea> virtualAreaCache;
 
 int syscall_0(int first, int second, int third, int forth, int fifth)
 {
@@ -38,14 +56,17 @@ void first_process()
         asm_halt();
     } else {
         if(pid) {
-            while((pid = wait(nullptr)) != -1) {
-
+            int retval;
+            while((pid = wait(&retval)) != -1) {
+                printf("first process: child %d exited with %d\n", pid, retval);
             }
-            asm_halt();
+            printf("first process: all children exited\n");
+            exit(0);
         } else {
             Shell shell;
             shell.initialize();
             shell.run();
+            exit(0);
         }
     }
 
@@ -54,9 +75,13 @@ void first_process()
 void first_thread(void *arg)
 {
 
+    // 后台清零线程，只利用空闲的处理器时间
+    programManager.executeThread(zero_page_thread, nullptr, "zero page", LOWEST_PRIORITY);
+    // 回收已退出进程的地址空间的线程
+    programManager.executeThread(reaper_thread, nullptr, "reaper", 1);
+
     printf("start process\n");
     programManager.executeProcess((const char *)first_process, 1);
-    asm_halt();
 }
 
 extern "C" void setup_kernel()
@@ -70,8 +95,18 @@ extern "C" void setup_kernel()
     // 输出管理器
     stdio.initialize();
 
-    // 进程/线程管理器
-    programManager.initialize();
+    // 时钟，每秒产生HZ次时钟中断
+    systemClock.initialize(HZ);
+
+    // 定时器管理器
+    timerManager.initialize();
+
+    // 进程/线程管理器，调度算法可选ROUND_ROBIN_POLICY或FAIR_POLICY，由make build FAIR=1选择后者
+#ifdef FAIR_SCHEDULING
+    programManager.initialize(SchedulingPolicy::FAIR_POLICY);
+#else
+    programManager.initialize(SchedulingPolicy::ROUND_ROBIN_POLICY);
+#endif
 
     // 初始化系统调用
     systemService.initialize();
@@ -87,9 +122,41 @@ extern "C" void setup_kernel()
     systemService.setSystemCall(4, (int)syscall_wait);
     // 设置5号系统调用
     systemService.setSystemCall(5, (int)syscall_move_cursor);
-
-    // 内存管理器
-    memoryManager.initialize();
+    // 设置6号系统调用
+    systemService.setSystemCall(6, (int)syscall_benchmark);
+    // 设置7号系统调用
+    systemService.setSystemCall(7, (int)syscall_sbrk);
+    // 设置8号系统调用
+    systemService.setSystemCall(8, (int)syscall_yield);
+    // 设置9号系统调用
+    systemService.setSystemCall(9, (int)syscall_memory_stat);
+    // 设置10号系统调用
+    systemService.setSystemCall(10, (int)syscall_shm_create);
+    // 设置11号系统调用
+    systemService.setSystemCall(11, (int)syscall_shm_attach);
+    // 设置12号系统调用
+    systemService.setSystemCall(12, (int)syscall_shm_detach);
+    // 设置13号系统调用
+    systemService.setSystemCall(13, (int)syscall_cpu_stat);
+    // 设置14号系统调用
+    systemService.setSystemCall(14, (int)syscall_clock_gettime);
+    // 设置15号系统调用
+    systemService.setSystemCall(15, (int)syscall_nanosleep);
+    // 设置16号系统调用
+    systemService.setSystemCall(16, (int)syscall_process_stat);
+
+    // 内存管理器，物理地址池可选BITMAP_BACKEND或BUDDY_BACKEND
+    memoryManager.initialize(PhysicalPoolBackend::BITMAP_BACKEND);
+
+    // 内核对象分配器
+    slabAllocator.initialize();
+    virtualAreaCache.initialize("vma");
+
+    // 交换区管理器
+    swapManager.initialize();
+
+    // 共享内存管理器
+    sharedMemoryManager.initialize();
 
     // 创建第一个线程
     int pid = programManager.executeThread(first_thread, nullptr, "first thread", 1);
@@ -99,10 +166,8 @@ extern "C" void setup_kernel()
         asm_halt();
     }
 
-    ListItem *item = programManager.readyPrograms.front();
-    PCB *firstThread = ListItem2PCB(item, tagInGeneralList);
+    PCB *firstThread = programManager.takeReady();
     firstThread->status = ProgramStatus::RUNNING;
-    programManager.readyPrograms.pop_front();
     programManager.running = firstThread;
     asm_switch_thread(0, firstThread);
 
@@ -2,6 +2,8 @@
 #include "asm_utils.h"
 #include "syscall.h"
 #include "stdio.h"
+#include "malloc.h"
+#include "stdlib.h"
 
 Shell::Shell()
 {
@@ -38,9 +40,15 @@ void Shell::run()
            "           YuZe Fu,\n"
            "           Nelson Cheung.\n\n"
            );
-    
 
-    asm_halt();
+#ifdef BOOT_BENCHMARK
+    // 基准测试会占满内存池、换出页面，只在编译时指定后运行
+    // 先运行基准测试，之后输出的统计信息包括测试产生的换页、回收等
+    benchmark();
+    memoryInfo();
+    cpuInfo();
+    processInfo();
+#endif
 }
 
 void Shell::printLogo()
@@ -55,4 +63,273 @@ void Shell::printLogo()
     printf(" ___) | |_| | |  | | |  | | |___|  _ <\n");
     move_cursor(4, 19);
     printf("|____/ \\___/|_|  |_|_|  |_|_____|_| \\_\\\n");
-}
\ No newline at end of file
+}
+
+void Shell::benchmark()
+{
+    printf("$ bench\n");
+    ::benchmark(BenchmarkType::BITMAP_BENCHMARK);
+    mallocBenchmark();
+    ::benchmark(BenchmarkType::FAULT_BENCHMARK);
+    ::benchmark(BenchmarkType::MAPPING_BENCHMARK);
+    ::benchmark(BenchmarkType::TLB_BENCHMARK);
+    ::benchmark(BenchmarkType::SWITCH_BENCHMARK);
+    switchBenchmark();
+    sharedMemoryBenchmark();
+    ::benchmark(BenchmarkType::STRING_BENCHMARK);
+    ::benchmark(BenchmarkType::LIST_BENCHMARK);
+    ::benchmark(BenchmarkType::DISPATCH_BENCHMARK);
+    ::benchmark(BenchmarkType::FAIR_BENCHMARK);
+    ::benchmark(BenchmarkType::SPAWN_BENCHMARK);
+}
+
+void Shell::mallocBenchmark()
+{
+    // 后面的块保持已分配，a、b、c释放后不会归还给堆中尚未划分的区域
+    char *a = (char *)malloc(8192);
+    char *b = (char *)malloc(8192);
+    char *c = (char *)malloc(8192);
+    char *guard = (char *)malloc(4096);
+    if (!a || !b || !c || !guard)
+    {
+        printf("bench malloc: out of memory\n");
+        return;
+    }
+
+    // 三个相邻的块合并后能容纳它们和两个头部
+    free(a);
+    free(c);
+    free(b);
+    char *merged = (char *)malloc(3 * 8192 + 2 * sizeof(MallocBlock));
+    bool coalesce = merged == a;
+
+    // 合并后的块能分割出两个相邻的4KB的块
+    free(merged);
+    char *first = (char *)malloc(4096);
+    char *second = (char *)malloc(4096);
+    bool split = first == a && second == a + 4096 + sizeof(MallocBlock);
+    free(first);
+    free(second);
+    free(guard);
+
+    printf("bench malloc: coalesce %s, split %s\n", coalesce ? "ok" : "FAIL", split ? "ok" : "FAIL");
+
+    // 大小从16B到32KB循环的64个块，先全部分配，再隔一个释放，最后释放其余的
+    void *blocks[64];
+    uint64 mallocCycles = 0;
+    uint64 freeCycles = 0;
+    // 第0轮扩展堆并触发缺页，不计入耗时
+    for (int round = 0; round <= BENCHMARK_ROUNDS; ++round)
+    {
+        uint64 start = asm_read_tsc();
+        for (int i = 0; i < 64; ++i)
+        {
+            blocks[i] = malloc(16 << (i % 12));
+        }
+        uint64 middle = asm_read_tsc();
+        for (int i = 0; i < 64; i += 2)
+        {
+            free(blocks[i]);
+        }
+        for (int i = 1; i < 64; i += 2)
+        {
+            free(blocks[i]);
+        }
+        uint64 end = asm_read_tsc();
+
+        if (round)
+        {
+            mallocCycles += middle - start;
+            freeCycles += end - middle;
+        }
+    }
+
+    printf("bench malloc: %d cycles per malloc, %d per free\n",
+           asm_divide(mallocCycles, BENCHMARK_ROUNDS * 64),
+           asm_divide(freeCycles, BENCHMARK_ROUNDS * 64));
+}
+
+void Shell::switchBenchmark()
+{
+    int pid = fork();
+    if (pid == -1)
+    {
+        printf("bench switch: can not fork\n");
+        return;
+    }
+
+    // 父子进程是同一优先级中仅有的就绪进程，每次让出都切换到对方
+    uint64 start = asm_read_tsc();
+    for (int i = 0; i < SWITCH_BENCHMARK_ROUNDS; ++i)
+    {
+        yield();
+    }
+    uint64 cycles = asm_read_tsc() - start;
+
+    if (!pid)
+    {
+        exit(0);
+    }
+
+    wait(nullptr);
+    printf("bench switch: process %d cycles\n", asm_divide(cycles, 2 * SWITCH_BENCHMARK_ROUNDS));
+}
+
+void Shell::sharedMemoryBenchmark()
+{
+    int id = shm_create(16 * PAGE_SIZE);
+    char *segment = (id == -1) ? (char *)-1 : (char *)shm_attach(id);
+    char *message = (char *)malloc(PAGE_SIZE + 1);
+    if ((int)segment == -1 || !message)
+    {
+        printf("bench shm: can not create segment\n");
+        return;
+    }
+
+    // 生产者把消息复制到共享内存后，消费者直接读取，不经过内核
+    int sizes[] = {64, PAGE_SIZE};
+    uint32 shm[2];
+    memset(message, 'x', PAGE_SIZE);
+    for (int i = 0; i < 2; ++i)
+    {
+        uint64 start = asm_read_tsc();
+        for (int round = 0; round < BENCHMARK_ROUNDS; ++round)
+        {
+            memcpy(message, segment + (round % 16) * PAGE_SIZE, sizes[i]);
+        }
+        shm[i] = asm_divide(asm_read_tsc() - start, BENCHMARK_ROUNDS);
+    }
+
+    // write的消息输出到屏幕的最后一行，每次输出前回到行首，最后清除
+    uint64 cycles = 0;
+    message[64] = '\0';
+    for (int round = 0; round < BENCHMARK_ROUNDS; ++round)
+    {
+        move_cursor(24, 0);
+        uint64 start = asm_read_tsc();
+        write(message);
+        cycles += asm_read_tsc() - start;
+    }
+    memset(message, ' ', 64);
+    move_cursor(24, 0);
+    write(message);
+    move_cursor(24, 0);
+
+    printf("bench shm: 64 B message, shm %d cycles, write %d cycles; 4 KB message, shm %d cycles\n",
+           shm[0], asm_divide(cycles, BENCHMARK_ROUNDS), shm[1]);
+
+    shm_detach((int)segment);
+    free(message);
+}
+
+void Shell::memoryInfo()
+{
+    MemoryStatistics statistics;
+
+    if (memory_stat(&statistics) == -1)
+    {
+        printf("meminfo: can not get memory statistics\n");
+        return;
+    }
+
+    printf("$ meminfo\n");
+    printPool("kernel physical", statistics.kernelPhysical);
+    printPool("user physical", statistics.userPhysical);
+    printPool("kernel virtual", statistics.kernelVirtual);
+    printZeroPool("kernel zero", statistics.kernelZero);
+    printZeroPool("user zero", statistics.userZero);
+    printLatency("allocatePages", statistics.allocateLatency);
+    printLatency("releasePages", statistics.releaseLatency);
+    printf("swap: out %d, in %d\n", statistics.swapOuts, statistics.swapIns);
+    for (int i = 0; i < statistics.cacheAmount; ++i)
+    {
+        printCache(statistics.caches[i]);
+    }
+}
+
+void Shell::cpuInfo()
+{
+    CPUStatistics statistics;
+
+    if (cpu_stat(&statistics) == -1)
+    {
+        printf("cpuinfo: can not get cpu statistics\n");
+        return;
+    }
+
+    int busy = statistics.totalTicks - statistics.idleTicks;
+    printf("$ cpuinfo\n");
+    printf("ticks: total %d, idle %d, busy %d, utilization %d%%\n",
+           statistics.totalTicks, statistics.idleTicks, busy,
+           statistics.totalTicks ? busy * 100 / statistics.totalTicks : 0);
+    printf("reaper: queued %d, max queued %d, reaped %d programs, %d frames, %d ticks\n",
+           statistics.reaperQueueDepth, statistics.maxReaperQueueDepth,
+           statistics.reapedPrograms, statistics.reapedFrames, statistics.reapTicks);
+
+    TimeSpec time;
+    if (clock_gettime(&time) != -1)
+    {
+        printf("uptime: %d s %d ms\n", time.seconds, time.nanoseconds / 1000000);
+    }
+}
+
+void Shell::processInfo()
+{
+    ProcessStatistics statistics[MAX_PROGRAM_AMOUNT];
+
+    int amount = process_stat(statistics, MAX_PROGRAM_AMOUNT);
+    if (amount == -1)
+    {
+        printf("ps: can not get process statistics\n");
+        return;
+    }
+
+    printf("$ ps\n");
+    for (int i = 0; i < amount; ++i)
+    {
+        printf("pid %d %s: status %d, lazy pages %d, faults demand %d, cow %d, swap %d\n",
+               statistics[i].pid, statistics[i].name, statistics[i].status,
+               statistics[i].lazyPages, statistics[i].demandFaults, statistics[i].cowFaults,
+               statistics[i].swapFaults);
+    }
+}
+
+void Shell::printPool(const char *name, const PoolStatistics &pool)
+{
+    printf("%s: free %d/%d, largest %d, frag %d%%, alloc %d, fail %d, release %d\n",
+           name, pool.freePages, pool.totalPages, pool.largestFree, pool.fragmentation,
+           pool.allocations, pool.failures, pool.releases);
+}
+
+void Shell::printZeroPool(const char *name, const ZeroPoolStatistics &pool)
+{
+    printf("%s: pages %d/%d, hit %d, miss %d, refill %d\n",
+           name, pool.pages, ZERO_POOL_PAGES, pool.hits, pool.misses, pool.refills);
+}
+
+void Shell::printLatency(const char *name, const LatencyHistogram &latency)
+{
+    // 每一项为 桶号:操作数，第i个桶表示耗时在[2^i, 2^(i+1))个时钟周期内
+    printf("%s: %d calls, max %d cycles, log2 histogram", name, latency.count, latency.maximum);
+    for (int i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        if (latency.buckets[i])
+        {
+            printf(" %d:%d", i, latency.buckets[i]);
+        }
+    }
+    printf("\n");
+}
+
+void Shell::printCache(const SlabStatistics &cache)
+{
+    // 未使用过的cache不输出
+    if (!cache.allocations)
+    {
+        return;
+    }
+
+    printf("slab %s: size %d, %d per slab, slabs %d, in use %d, alloc %d, release %d\n",
+           cache.name, cache.objectSize, cache.objectsPerSlab, cache.slabs,
+           cache.inUse, cache.allocations, cache.releases);
+}
@@ -0,0 +1,224 @@
+#include "shm.h"
+#include "memory.h"
+#include "program.h"
+#include "slab.h"
+#include "stdlib.h"
+#include "os_constant.h"
+#include "os_modules.h"
+
+SharedMemoryManager::SharedMemoryManager()
+{
+}
+
+void SharedMemoryManager::initialize()
+{
+    for (int i = 0; i < MAX_SHARED_SEGMENTS; ++i)
+    {
+        segments[i].pages = 0;
+        segments[i].frames = nullptr;
+        segments[i].attached = false;
+        segments[i].creator = -1;
+    }
+
+    created = 0;
+    destroyed = 0;
+}
+
+int SharedMemoryManager::create(const int size)
+{
+    PCB *program = programManager.running;
+
+    // 内核线程没有用户地址空间
+    if (size <= 0 || !program->pageDirectoryAddress)
+    {
+        return -1;
+    }
+
+    int pages = ceil(size, PAGE_SIZE);
+    if (pages > MAX_SHARED_PAGES)
+    {
+        return -1;
+    }
+
+    // 段表和物理地址池没有锁保护，关中断访问
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int id = -1;
+    for (int i = 0; i < MAX_SHARED_SEGMENTS; ++i)
+    {
+        if (!segments[i].pages)
+        {
+            id = i;
+            break;
+        }
+    }
+
+    if (id == -1)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    int *frames = (int *)kmalloc(pages * sizeof(int));
+    if (!frames)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    // 段本身持有每个物理页的一个引用，不映射到任何进程时也不会被释放
+    for (int i = 0; i < pages; ++i)
+    {
+        frames[i] = memoryManager.allocateZeroedPage(AddressPoolType::USER);
+        if (!frames[i])
+        {
+            for (int j = 0; j < i; ++j)
+            {
+                memoryManager.releasePhysicalPages(AddressPoolType::USER, frames[j], 1);
+            }
+            kfree(frames);
+            interruptManager.setInterruptStatus(status);
+            return -1;
+        }
+    }
+
+    segments[id].pages = pages;
+    segments[id].frames = frames;
+    segments[id].attached = false;
+    segments[id].creator = program->pid;
+    ++created;
+
+    interruptManager.setInterruptStatus(status);
+    return id;
+}
+
+int SharedMemoryManager::attach(const int id)
+{
+    PCB *program = programManager.running;
+
+    // 内核线程没有用户地址空间
+    if (id < 0 || id >= MAX_SHARED_SEGMENTS || !program->pageDirectoryAddress)
+    {
+        return -1;
+    }
+
+    // 段表、页表和虚拟地址树没有锁保护，关中断访问
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    SharedSegment &segment = segments[id];
+    if (!segment.pages)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    int address = program->userVirtual.allocate(segment.pages, VirtualAreaType::SHARED_AREA);
+    if (address == -1)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    int vaddr = address;
+    for (int i = 0; i < segment.pages; ++i, vaddr += PAGE_SIZE)
+    {
+        if (!memoryManager.connectPhysicalVirtualPage(vaddr, segment.frames[i]))
+        {
+            memoryManager.unmapPages(AddressPoolType::USER, address, i);
+            program->userVirtual.release(address, segment.pages);
+            interruptManager.setInterruptStatus(status);
+            return -1;
+        }
+
+        // 共享的页不记录反向映射，不会被换出
+        *((int *)memoryManager.toPTE(vaddr)) |= PAGE_SHARED;
+        memoryManager.addFrameReference(segment.frames[i]);
+    }
+
+    segment.attached = true;
+
+    interruptManager.setInterruptStatus(status);
+    return address;
+}
+
+int SharedMemoryManager::detach(const int address)
+{
+    PCB *program = programManager.running;
+
+    if (!program->pageDirectoryAddress || (address & 0xfff))
+    {
+        return -1;
+    }
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    VirtualArea *area = program->userVirtual.find(address);
+    if (!area || area->type != VirtualAreaType::SHARED_AREA)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    // 共享内存段映射后页表项一直存在，由起始页的物理地址找到段
+    int paddr = memoryManager.vaddr2paddr(address);
+    int id = -1;
+    for (int i = 0; i < MAX_SHARED_SEGMENTS; ++i)
+    {
+        if (segments[i].pages && segments[i].frames[0] == paddr)
+        {
+            id = i;
+            break;
+        }
+    }
+
+    if (id == -1)
+    {
+        interruptManager.setInterruptStatus(status);
+        return -1;
+    }
+
+    memoryManager.unmapPages(AddressPoolType::USER, address, segments[id].pages);
+    program->userVirtual.release(address, segments[id].pages);
+    collect();
+
+    interruptManager.setInterruptStatus(status);
+    return 0;
+}
+
+void SharedMemoryManager::collect(const int pid)
+{
+    for (int i = 0; i < MAX_SHARED_SEGMENTS; ++i)
+    {
+        if (!segments[i].pages)
+        {
+            continue;
+        }
+
+        // 被映射过的段只剩段本身持有的引用，或从未被映射过的段的创建者已退出
+        if ((segments[i].attached && memoryManager.getFrameReference(segments[i].frames[0]) == 1) ||
+            (!segments[i].attached && pid != -1 && segments[i].creator == pid))
+        {
+            destroy(i);
+        }
+    }
+}
+
+void SharedMemoryManager::destroy(const int id)
+{
+    SharedSegment &segment = segments[id];
+
+    for (int i = 0; i < segment.pages; ++i)
+    {
+        memoryManager.releasePhysicalPages(AddressPoolType::USER, segment.frames[i], 1);
+    }
+
+    kfree(segment.frames);
+    segment.pages = 0;
+    segment.frames = nullptr;
+    segment.attached = false;
+    segment.creator = -1;
+    ++destroyed;
+}
@@ -0,0 +1,269 @@
+#include "slab.h"
+#include "memory.h"
+#include "stdlib.h"
+#include "os_constant.h"
+#include "os_modules.h"
+
+SlabCache::SlabCache()
+{
+}
+
+void SlabCache::initialize(const char *name, const int objectSize)
+{
+    int i;
+    for (i = 0; i < SLAB_NAME_LENGTH && name[i]; ++i)
+    {
+        this->name[i] = name[i];
+    }
+    this->name[i] = '\0';
+
+    // 空闲对象需要存放下一个空闲对象的地址，对象大小按4字节对齐
+    this->objectSize = objectSize < 4 ? 4 : ceil(objectSize, 4) * 4;
+    this->objectOffset = ceil(sizeof(SlabHeader), 8) * 8;
+    this->objectsPerSlab = (PAGE_SIZE - objectOffset) / this->objectSize;
+
+    partialSlabs.initialize();
+    fullSlabs.initialize();
+    emptySlabs.initialize();
+
+    slabs = 0;
+    inUse = 0;
+    allocations = 0;
+    releases = 0;
+
+    slabAllocator.allCaches.push_back(&tagInCacheList);
+}
+
+void *SlabCache::allocate()
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    SlabHeader *slab = nullptr;
+
+    // 优先使用部分分配的slab，其次是空闲的slab，最后才分配新的slab
+    if (partialSlabs.front())
+    {
+        slab = container_of(partialSlabs.front(), &SlabHeader::tagInSlabList);
+    }
+    else if (emptySlabs.front())
+    {
+        slab = container_of(emptySlabs.front(), &SlabHeader::tagInSlabList);
+        emptySlabs.pop_front();
+        partialSlabs.push_front(&(slab->tagInSlabList));
+    }
+    else
+    {
+        slab = createSlab();
+        if (!slab)
+        {
+            interruptManager.setInterruptStatus(status);
+            return nullptr;
+        }
+        partialSlabs.push_front(&(slab->tagInSlabList));
+    }
+
+    // 取出第一个空闲对象
+    void *object = slab->freeObject;
+    slab->freeObject = *((void **)object);
+    ++slab->inUse;
+
+    if (slab->inUse == objectsPerSlab)
+    {
+        partialSlabs.erase(&(slab->tagInSlabList));
+        fullSlabs.push_front(&(slab->tagInSlabList));
+    }
+
+    ++inUse;
+    ++allocations;
+
+    interruptManager.setInterruptStatus(status);
+    return object;
+}
+
+void SlabCache::release(void *object)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    SlabHeader *slab = (SlabHeader *)((int)object & 0xfffff000);
+
+    if (slab->inUse == objectsPerSlab)
+    {
+        fullSlabs.erase(&(slab->tagInSlabList));
+        partialSlabs.push_front(&(slab->tagInSlabList));
+    }
+
+    // 放回空闲对象链表
+    *((void **)object) = slab->freeObject;
+    slab->freeObject = object;
+    --slab->inUse;
+
+    if (!slab->inUse)
+    {
+        partialSlabs.erase(&(slab->tagInSlabList));
+
+        // 只保留一个空闲的slab，其余归还给内核地址池
+        if (emptySlabs.front())
+        {
+            memoryManager.releasePages(AddressPoolType::KERNEL, (int)slab, 1);
+            --slabs;
+        }
+        else
+        {
+            emptySlabs.push_front(&(slab->tagInSlabList));
+        }
+    }
+
+    --inUse;
+    ++releases;
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void SlabCache::getStatistics(SlabStatistics *statistics)
+{
+    strcpy(name, statistics->name);
+    statistics->objectSize = objectSize;
+    statistics->objectsPerSlab = objectsPerSlab;
+    statistics->slabs = slabs;
+    statistics->inUse = inUse;
+    statistics->allocations = allocations;
+    statistics->releases = releases;
+}
+
+SlabHeader *SlabCache::createSlab()
+{
+    if (objectsPerSlab <= 0)
+    {
+        return nullptr;
+    }
+
+    int page = memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
+    if (!page)
+    {
+        return nullptr;
+    }
+
+    SlabHeader *slab = (SlabHeader *)page;
+    slab->cache = this;
+    slab->inUse = 0;
+
+    // 将slab中的对象串成空闲对象链表
+    char *object = (char *)page + objectOffset;
+    slab->freeObject = object;
+    for (int i = 0; i < objectsPerSlab - 1; ++i, object += objectSize)
+    {
+        *((void **)object) = object + objectSize;
+    }
+    *((void **)object) = nullptr;
+
+    ++slabs;
+    return slab;
+}
+
+SlabAllocator::SlabAllocator()
+{
+}
+
+void SlabAllocator::initialize()
+{
+    allCaches.initialize();
+
+    char name[SLAB_NAME_LENGTH + 1];
+    int size = SLAB_MIN_SIZE;
+
+    strcpy("kmalloc-", name);
+
+    for (int i = 0; i < SLAB_CLASS_AMOUNT; ++i, size *= 2)
+    {
+        itos(name + 8, size, 10);
+        caches[i].initialize(name, size);
+    }
+}
+
+void *SlabAllocator::allocate(const int size)
+{
+    if (size <= 0)
+    {
+        return nullptr;
+    }
+
+    // 找到能容纳size个字节的最小的大小类别
+    int index = 0;
+    int classSize = SLAB_MIN_SIZE;
+    while (index < SLAB_CLASS_AMOUNT && classSize < size)
+    {
+        ++index;
+        classSize *= 2;
+    }
+
+    if (index < SLAB_CLASS_AMOUNT)
+    {
+        return caches[index].allocate();
+    }
+
+    // 大块内存直接按页分配，页的开头同样存放SlabHeader
+    int offset = ceil(sizeof(SlabHeader), 8) * 8;
+    int pages = ceil(size + offset, PAGE_SIZE);
+    int start = memoryManager.allocatePages(AddressPoolType::KERNEL, pages);
+    if (!start)
+    {
+        return nullptr;
+    }
+
+    SlabHeader *header = (SlabHeader *)start;
+    header->cache = nullptr;
+    header->freeObject = nullptr;
+    header->inUse = pages;
+
+    return (void *)(start + offset);
+}
+
+void SlabAllocator::release(void *address)
+{
+    if (!address)
+    {
+        return;
+    }
+
+    SlabHeader *header = (SlabHeader *)((int)address & 0xfffff000);
+
+    if (header->cache)
+    {
+        header->cache->release(address);
+    }
+    else
+    {
+        memoryManager.releasePages(AddressPoolType::KERNEL, (int)header, header->inUse);
+    }
+}
+
+int SlabAllocator::getStatistics(SlabStatistics *statistics, const int max)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int amount = 0;
+    SlabCache *cache = allCaches.first(&SlabCache::tagInCacheList);
+
+    while (cache && amount < max)
+    {
+        cache->getStatistics(&statistics[amount]);
+        ++amount;
+        cache = allCaches.next(cache, &SlabCache::tagInCacheList);
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return amount;
+}
+
+void *kmalloc(const int size)
+{
+    return slabAllocator.allocate(size);
+}
+
+void kfree(void *address)
+{
+    slabAllocator.release(address);
+}
@@ -101,11 +101,8 @@ void STDIO::rollUp()
 {
     uint length;
     length = 25 * 80;
-    for (uint i = 80; i < length; ++i)
-    {
-        screen[2 * (i - 80)] = screen[2 * i];
-        screen[2 * (i - 80) + 1] = screen[2 * i + 1];
-    }
+    // 第1~24行整体上移一行
+    memmove(screen + 2 * 80, screen, 2 * (length - 80));
 
     for (uint i = 24 * 80; i < length; ++i)
     {
@@ -0,0 +1,191 @@
+#include "swap.h"
+#include "memory.h"
+#include "stdlib.h"
+#include "stdio.h"
+#include "asm_utils.h"
+#include "os_constant.h"
+#include "os_modules.h"
+
+SwapManager::SwapManager()
+{
+}
+
+void SwapManager::initialize()
+{
+    // 页槽的位图和引用计数存放在同一页中
+    char *page = (char *)memoryManager.allocatePages(AddressPoolType::KERNEL, 1);
+    if (!page)
+    {
+        printf("can not initialize swap area\n");
+        return;
+    }
+
+    slotReferences = (uint8 *)page;
+    memset(slotReferences, 0, SWAP_PAGES);
+    slots.initialize(page + SWAP_PAGES, SWAP_PAGES);
+
+    clockHand = 0;
+    swapOuts = 0;
+    swapIns = 0;
+
+    printf("swap area\n"
+           "    start sector: %d\n"
+           "    total pages: %d ( %d MB )\n",
+           SWAP_START_SECTOR, SWAP_PAGES, SWAP_PAGES * PAGE_SIZE / 1024 / 1024);
+}
+
+bool SwapManager::swapOut()
+{
+    // 从修改页表项到写完页槽之间不能切换线程，否则页所在的进程可能在写完之前换入该页槽，
+    // 或者在页被释放之前继续写入它。writePage以轮询方式读写硬盘，不需要中断
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    int frames = memoryManager.userPhysical.resources.size();
+    int index, paddr, slot, *pte;
+    FrameMapping *mapping;
+
+    // 至多扫描两圈，第一圈清除的访问位在第二圈时仍为0
+    for (int step = 0; step < 2 * frames; ++step)
+    {
+        index = clockHand;
+        clockHand = (clockHand + 1) % frames;
+
+        // 只换出仅被一个进程映射的页
+        mapping = &memoryManager.userFrameMappings[index];
+        if (!mapping->owner || memoryManager.userFrameReferences[index] != 1)
+        {
+            continue;
+        }
+
+        paddr = memoryManager.userPhysical.startAddress + index * PAGE_SIZE;
+
+        // 通过直接映射区访问页所在进程的页表
+        int pde = ((int *)mapping->owner->pageDirectoryAddress)[(uint32)mapping->vaddr >> 22];
+        if (!(pde & 0x1))
+        {
+            mapping->owner = nullptr;
+            continue;
+        }
+
+        pte = (int *)phys2virt(pde & 0xfffff000) + (((uint32)mapping->vaddr >> 12) & 0x3ff);
+
+        // 反向映射已失效
+        if (!(*pte & 0x1) || (int)(*pte & 0xfffff000) != paddr)
+        {
+            mapping->owner = nullptr;
+            continue;
+        }
+
+        // A=1，最近被访问过，清除访问位后给予第二次机会
+        // 处理器只在装入TLB项时设置A位，当前进程的页需要使TLB项失效，否则之后的访问不会再设置A位
+        if (*pte & 0x20)
+        {
+            *pte &= ~0x20;
+            if (mapping->owner == programManager.running)
+            {
+                memoryManager.invalidatePage(mapping->vaddr);
+            }
+            continue;
+        }
+
+        // 选出被换出的页后才分配页槽，交换区已满时页表项保持不变
+        slot = slots.allocate(1);
+        if (slot == -1)
+        {
+            break;
+        }
+
+        // 页表项记录页槽号，保留除P、A、D以外的属性位
+        *pte = (slot << 12) | ((*pte) & 0xfff & ~0x61) | PAGE_SWAPPED;
+        slotReferences[slot] = 1;
+
+        // 页所在的进程若是当前进程，其旧的映射需要失效
+        if (mapping->owner == programManager.running)
+        {
+            memoryManager.invalidatePage(mapping->vaddr);
+        }
+        mapping->owner = nullptr;
+
+        writePage(slot, phys2virt(paddr));
+        memoryManager.releasePhysicalPages(AddressPoolType::USER, paddr, 1);
+
+        ++swapOuts;
+        interruptManager.setInterruptStatus(status);
+        return true;
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return false;
+}
+
+bool SwapManager::swapIn(const int address)
+{
+    int vaddr = address & 0xfffff000;
+
+    if ((uint32)vaddr >= KERNEL_DIRECT_MAP_START || !(*((int *)memoryManager.toPDE(vaddr)) & 0x1))
+    {
+        return false;
+    }
+
+    int *pte = (int *)memoryManager.toPTE(vaddr);
+    if ((*pte & 0x1) || !(*pte & PAGE_SWAPPED))
+    {
+        return false;
+    }
+
+    int paddr = memoryManager.allocatePhysicalPages(AddressPoolType::USER, 1);
+    if (!paddr)
+    {
+        return false;
+    }
+
+    int slot = (uint32)(*pte) >> 12;
+    readPage(slot, phys2virt(paddr));
+
+    *pte = paddr | ((*pte) & 0xfff & ~PAGE_SWAPPED) | 0x1;
+    memoryManager.setFrameMapping(paddr, programManager.running, vaddr);
+
+    if (!(--slotReferences[slot]))
+    {
+        slots.release(slot, 1);
+    }
+
+    ++swapIns;
+    return true;
+}
+
+void SwapManager::addReference(const int pte)
+{
+    ++slotReferences[(uint32)pte >> 12];
+}
+
+void SwapManager::release(const int pte)
+{
+    int slot = (uint32)pte >> 12;
+
+    if (slotReferences[slot] && !(--slotReferences[slot]))
+    {
+        slots.release(slot, 1);
+    }
+}
+
+void SwapManager::readPage(const int slot, const int vaddr)
+{
+    int sector = SWAP_START_SECTOR + slot * (PAGE_SIZE / SECTOR_SIZE);
+
+    for (int i = 0; i < PAGE_SIZE / SECTOR_SIZE; ++i)
+    {
+        asm_read_hard_disk((void *)(vaddr + i * SECTOR_SIZE), sector + i);
+    }
+}
+
+void SwapManager::writePage(const int slot, const int vaddr)
+{
+    int sector = SWAP_START_SECTOR + slot * (PAGE_SIZE / SECTOR_SIZE);
+
+    for (int i = 0; i < PAGE_SIZE / SECTOR_SIZE; ++i)
+    {
+        asm_write_hard_disk((void *)(vaddr + i * SECTOR_SIZE), sector + i);
+    }
+}
@@ -69,9 +69,9 @@ void Semaphore::V()
 {
     semLock.lock();
     ++counter;
-    if (waiting.size())
+    if (!waiting.empty())
     {
-        PCB *program = ListItem2PCB(waiting.front(), tagInGeneralList);
+        PCB *program = container_of(waiting.front(), &PCB::tagInGeneralList);
         waiting.pop_front();
         semLock.unlock();
         programManager.MESA_WakeUp(program);
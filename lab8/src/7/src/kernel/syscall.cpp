@@ -61,4 +61,123 @@ void move_cursor(int i, int j) {
 }
 void syscall_move_cursor(int i, int j) {
     stdio.moveCursor(i, j);
-}
\ No newline at end of file
+}
+
+int benchmark(int type) {
+    return asm_system_call(6, type);
+}
+
+int syscall_benchmark(int type) {
+    return run_benchmark(type);
+}
+
+int sbrk(int increment) {
+    return asm_system_call(7, increment);
+}
+
+int syscall_sbrk(int increment) {
+    return programManager.sbrk(increment);
+}
+
+int yield() {
+    return asm_system_call(8);
+}
+
+int syscall_yield() {
+    programManager.schedule();
+    return 0;
+}
+
+int memory_stat(MemoryStatistics *statistics) {
+    return asm_system_call(9, (int)statistics);
+}
+
+int syscall_memory_stat(MemoryStatistics *statistics) {
+    if (!statistics) {
+        return -1;
+    }
+
+    memoryManager.getStatistics(*statistics);
+    return 0;
+}
+
+int shm_create(int size) {
+    return asm_system_call(10, size);
+}
+
+int syscall_shm_create(int size) {
+    return sharedMemoryManager.create(size);
+}
+
+int shm_attach(int id) {
+    return asm_system_call(11, id);
+}
+
+int syscall_shm_attach(int id) {
+    return sharedMemoryManager.attach(id);
+}
+
+int shm_detach(int address) {
+    return asm_system_call(12, address);
+}
+
+int syscall_shm_detach(int address) {
+    return sharedMemoryManager.detach(address);
+}
+
+int cpu_stat(CPUStatistics *statistics) {
+    return asm_system_call(13, (int)statistics);
+}
+
+int syscall_cpu_stat(CPUStatistics *statistics) {
+    if (!statistics) {
+        return -1;
+    }
+
+    programManager.getStatistics(*statistics);
+    return 0;
+}
+
+int clock_gettime(TimeSpec *time) {
+    return asm_system_call(14, (int)time);
+}
+
+int syscall_clock_gettime(TimeSpec *time) {
+    if (!time) {
+        return -1;
+    }
+
+    systemClock.getTime(*time);
+    return 0;
+}
+
+int nanosleep(const TimeSpec *request) {
+    return asm_system_call(15, (int)request);
+}
+
+int syscall_nanosleep(const TimeSpec *request) {
+    if (!request || request->nanoseconds >= 1000000000) {
+        return -1;
+    }
+
+    if (!request->seconds && !request->nanoseconds) {
+        return 0;
+    }
+
+    // 当前时钟中断已经过去了一部分，多等一个时钟中断
+    uint32 ticks = request->seconds * HZ + ceil(request->nanoseconds, systemClock.nsPerTick) + 1;
+    timerManager.sleep(ticks);
+    return 0;
+}
+
+int process_stat(ProcessStatistics *statistics, int max) {
+    return asm_system_call(16, (int)statistics, max);
+}
+
+int syscall_process_stat(ProcessStatistics *statistics, int max) {
+    if (!statistics || max <= 0) {
+        return -1;
+    }
+
+    return programManager.getProcessStatistics(statistics, max);
+}
@@ -0,0 +1,189 @@
+#include "timer.h"
+#include "interrupt.h"
+#include "os_modules.h"
+#include "stdlib.h"
+
+// 唤醒sleep中阻塞的线程
+static void wake_sleeper(void *data)
+{
+    programManager.MESA_WakeUp((PCB *)data);
+}
+
+TimerManager::TimerManager()
+{
+}
+
+void TimerManager::initialize()
+{
+    for (int i = 0; i < TIMER_LEVELS; ++i)
+    {
+        for (int j = 0; j < TIMER_SLOTS; ++j)
+        {
+            wheel[i][j].initialize();
+        }
+    }
+
+    current = jiffies;
+    pending = 0;
+    expired = 0;
+    cancelled = 0;
+}
+
+void TimerManager::add(Timer *timer, uint32 ticks, TimerCallback callback, void *data)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    // 重新添加未到期的定时器时，先从原来的槽中取下
+    if (timer->slot)
+    {
+        timer->slot->erase(&(timer->tagInWheel));
+        --pending;
+    }
+
+    timer->expires = jiffies + ticks;
+    timer->callback = callback;
+    timer->data = data;
+
+    place(timer);
+    ++pending;
+
+    interruptManager.setInterruptStatus(status);
+}
+
+bool TimerManager::cancel(Timer *timer)
+{
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    bool flag = timer->slot != nullptr;
+    if (flag)
+    {
+        timer->slot->erase(&(timer->tagInWheel));
+        timer->slot = nullptr;
+        --pending;
+        ++cancelled;
+    }
+
+    interruptManager.setInterruptStatus(status);
+    return flag;
+}
+
+void TimerManager::sleep(uint32 ticks)
+{
+    // 线程阻塞期间栈不会被释放，定时器可以放在栈上
+    Timer timer;
+    timer.slot = nullptr;
+
+    bool status = interruptManager.getInterruptStatus();
+    interruptManager.disableInterrupt();
+
+    PCB *program = programManager.running;
+    add(&timer, ticks, wake_sleeper, program);
+    program->status = ProgramStatus::BLOCKED;
+    programManager.schedule();
+
+    interruptManager.setInterruptStatus(status);
+}
+
+void TimerManager::run()
+{
+    List work;
+    Timer *timer;
+    int index, level;
+
+    while ((int)(jiffies - current) >= 0)
+    {
+        index = current & (TIMER_SLOTS - 1);
+
+        // 第0层转完一圈，从高层的下一个槽中取出定时器重新分配，直到某一层没有转完一圈
+        if (!index)
+        {
+            for (level = 1; level < TIMER_LEVELS; ++level)
+            {
+                int slot = (current >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1);
+                cascade(level, slot);
+                if (slot)
+                {
+                    break;
+                }
+            }
+        }
+
+        ++current;
+
+        // 先取出到期的定时器，callback中添加的定时器不会在本次被处理
+        work.initialize();
+        while (!wheel[0][index].empty())
+        {
+            ListItem *item = wheel[0][index].front();
+            wheel[0][index].pop_front();
+            work.push_back(item);
+        }
+
+        while (!work.empty())
+        {
+            timer = container_of(work.front(), &Timer::tagInWheel);
+            work.pop_front();
+
+            timer->slot = nullptr;
+            --pending;
+            ++expired;
+
+            timer->callback(timer->data);
+        }
+    }
+}
+
+void TimerManager::place(Timer *timer)
+{
+    uint32 delta = timer->expires - current;
+    int level = 0;
+
+    if ((int)delta < 0)
+    {
+        // 已经到期，在下一次处理时调用
+        timer->expires = current;
+        delta = 0;
+    }
+    else if (delta >= (1u << (TIMER_LEVELS * TIMER_SLOT_BITS)))
+    {
+        timer->expires = current + (1u << (TIMER_LEVELS * TIMER_SLOT_BITS)) - 1;
+        delta = timer->expires - current;
+    }
+
+    // 能够容纳delta的最低的层
+    while (level < TIMER_LEVELS - 1 && delta >= (1u << ((level + 1) * TIMER_SLOT_BITS)))
+    {
+        ++level;
+    }
+
+    int index = (timer->expires >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1);
+    timer->slot = &wheel[level][index];
+    timer->slot->push_back(&(timer->tagInWheel));
+}
+
+void TimerManager::cascade(int level, int index)
+{
+    List &slot = wheel[level][index];
+    Timer *timer;
+
+    // 槽中的定时器都在高层转过这个槽之前到期，重新分配后进入更低的层
+    while (!slot.empty())
+    {
+        timer = container_of(slot.front(), &Timer::tagInWheel);
+        slot.pop_front();
+        place(timer);
+    }
+}
+
+void sleep_ms(int ms)
+{
+    if (ms <= 0)
+    {
+        return;
+    }
+
+    // 当前时钟中断已经过去了一部分，多等一个时钟中断保证阻塞的时间不少于ms毫秒
+    timerManager.sleep(ceil(ms * HZ, 1000) + 1);
+}
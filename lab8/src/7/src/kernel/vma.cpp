@@ -0,0 +1,412 @@
+#include "vma.h"
+#include "slab.h"
+#include "os_constant.h"
+#include "os_modules.h"
+
+VirtualAreaTree::VirtualAreaTree()
+{
+}
+
+void VirtualAreaTree::initialize(const int startAddress, const int endAddress)
+{
+    this->root = nullptr;
+    this->areas = 0;
+    this->startAddress = startAddress;
+    this->endAddress = endAddress;
+}
+
+int VirtualAreaTree::allocate(const int count, enum VirtualAreaType type)
+{
+    if (count <= 0)
+    {
+        return -1;
+    }
+
+    uint32 length = count * PAGE_SIZE;
+    uint32 previous = startAddress;
+
+    // 区域按地址有序，中序遍历找到的第一个间隙即首次适配的结果
+    int start = searchGap(root, previous, length);
+    if (start == -1)
+    {
+        // 最后一个区域之后的间隙
+        if (previous > endAddress || endAddress - previous < length)
+        {
+            return -1;
+        }
+        start = previous;
+    }
+
+    if (!insert(start, start + length, type))
+    {
+        return -1;
+    }
+
+    return start;
+}
+
+void VirtualAreaTree::release(const int address, const int amount)
+{
+    uint32 start = address;
+    uint32 end = start + amount * PAGE_SIZE;
+    VirtualArea *area;
+
+    if (amount <= 0)
+    {
+        return;
+    }
+
+    while ((area = findOverlap(start, end)))
+    {
+        if (area->start < start && area->end > end)
+        {
+            // 释放区域中间的页，区域被拆分为两个
+            uint32 oldEnd = area->end;
+            area->end = start;
+            if (!insert(end, oldEnd, area->type))
+            {
+                return;
+            }
+        }
+        else if (area->start < start)
+        {
+            area->end = start;
+        }
+        else if (area->end > end)
+        {
+            // 起始地址增大后仍在前后两个区域之间，树的顺序不变
+            area->start = end;
+        }
+        else
+        {
+            root = removeNode(root, area->start);
+            --areas;
+        }
+    }
+}
+
+bool VirtualAreaTree::reserve(const int address, const int amount, enum VirtualAreaType type)
+{
+    uint32 start = address;
+    uint32 end = start + amount * PAGE_SIZE;
+
+    if (amount <= 0 || start < startAddress || end > endAddress || findOverlap(start, end))
+    {
+        return false;
+    }
+
+    return insert(start, end, type);
+}
+
+VirtualArea *VirtualAreaTree::find(const int address)
+{
+    return findOverlap(address, (uint32)address + 1);
+}
+
+bool VirtualAreaTree::copy(const VirtualAreaTree &source)
+{
+    bool flag = true;
+
+    clear();
+    startAddress = source.startAddress;
+    endAddress = source.endAddress;
+    root = copyNode(source.root, flag);
+    areas = source.areas;
+
+    if (!flag)
+    {
+        clear();
+    }
+
+    return flag;
+}
+
+void VirtualAreaTree::clear()
+{
+    clearNode(root);
+    root = nullptr;
+    areas = 0;
+}
+
+bool VirtualAreaTree::insert(const uint32 start, const uint32 end, enum VirtualAreaType type)
+{
+    VirtualArea *previous = predecessor(start);
+    VirtualArea *next = successor(start);
+
+    // 与前一个区域相邻，扩展前一个区域，必要时与后一个区域连成一个
+    if (previous && previous->end == start && previous->type == type)
+    {
+        previous->end = end;
+        if (next && next->start == end && next->type == type)
+        {
+            previous->end = next->end;
+            root = removeNode(root, next->start);
+            --areas;
+        }
+        return true;
+    }
+
+    // 与后一个区域相邻，向前扩展后一个区域
+    if (next && next->start == end && next->type == type)
+    {
+        next->start = start;
+        return true;
+    }
+
+    VirtualArea *area = virtualAreaCache.allocate();
+    if (!area)
+    {
+        return false;
+    }
+
+    area->start = start;
+    area->end = end;
+    area->type = type;
+    area->left = nullptr;
+    area->right = nullptr;
+    area->height = 1;
+
+    root = insertNode(root, area);
+    ++areas;
+
+    return true;
+}
+
+VirtualArea *VirtualAreaTree::insertNode(VirtualArea *node, VirtualArea *area)
+{
+    if (!node)
+    {
+        return area;
+    }
+
+    if (area->start < node->start)
+    {
+        node->left = insertNode(node->left, area);
+    }
+    else
+    {
+        node->right = insertNode(node->right, area);
+    }
+
+    return balance(node);
+}
+
+VirtualArea *VirtualAreaTree::removeNode(VirtualArea *node, const uint32 start)
+{
+    if (!node)
+    {
+        return nullptr;
+    }
+
+    if (start < node->start)
+    {
+        node->left = removeNode(node->left, start);
+    }
+    else if (start > node->start)
+    {
+        node->right = removeNode(node->right, start);
+    }
+    else
+    {
+        if (!node->left || !node->right)
+        {
+            VirtualArea *child = node->left ? node->left : node->right;
+            virtualAreaCache.release(node);
+            return child;
+        }
+
+        // 有两个子树时，用右子树中的第一个区域代替node，再删除该区域
+        VirtualArea *next = node->right;
+        while (next->left)
+        {
+            next = next->left;
+        }
+
+        node->start = next->start;
+        node->end = next->end;
+        node->type = next->type;
+        node->right = removeNode(node->right, next->start);
+    }
+
+    return balance(node);
+}
+
+VirtualArea *VirtualAreaTree::findOverlap(const uint32 start, const uint32 end)
+{
+    VirtualArea *node = root;
+
+    // 区域互不重叠，按起始地址排序的同时也按结束地址排序
+    while (node)
+    {
+        if (node->end <= start)
+        {
+            node = node->right;
+        }
+        else if (node->start >= end)
+        {
+            node = node->left;
+        }
+        else
+        {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+VirtualArea *VirtualAreaTree::predecessor(const uint32 address)
+{
+    VirtualArea *node = root;
+    VirtualArea *result = nullptr;
+
+    while (node)
+    {
+        if (node->start < address)
+        {
+            result = node;
+            node = node->right;
+        }
+        else
+        {
+            node = node->left;
+        }
+    }
+
+    return result;
+}
+
+VirtualArea *VirtualAreaTree::successor(const uint32 address)
+{
+    VirtualArea *node = root;
+    VirtualArea *result = nullptr;
+
+    while (node)
+    {
+        if (node->start >= address)
+        {
+            result = node;
+            node = node->left;
+        }
+        else
+        {
+            node = node->right;
+        }
+    }
+
+    return result;
+}
+
+int VirtualAreaTree::searchGap(VirtualArea *node, uint32 &previous, const uint32 length)
+{
+    if (!node)
+    {
+        return -1;
+    }
+
+    int start = searchGap(node->left, previous, length);
+    if (start != -1)
+    {
+        return start;
+    }
+
+    if (node->start - previous >= length)
+    {
+        return previous;
+    }
+    previous = node->end;
+
+    return searchGap(node->right, previous, length);
+}
+
+VirtualArea *VirtualAreaTree::copyNode(VirtualArea *node, bool &flag)
+{
+    if (!node || !flag)
+    {
+        return nullptr;
+    }
+
+    VirtualArea *area = virtualAreaCache.allocate();
+    if (!area)
+    {
+        flag = false;
+        return nullptr;
+    }
+
+    // 保持原树的形状，复制后无需重新平衡
+    area->start = node->start;
+    area->end = node->end;
+    area->type = node->type;
+    area->height = node->height;
+    area->left = copyNode(node->left, flag);
+    area->right = copyNode(node->right, flag);
+
+    return area;
+}
+
+void VirtualAreaTree::clearNode(VirtualArea *node)
+{
+    if (!node)
+    {
+        return;
+    }
+
+    clearNode(node->left);
+    clearNode(node->right);
+    virtualAreaCache.release(node);
+}
+
+VirtualArea *VirtualAreaTree::balance(VirtualArea *node)
+{
+    int left = height(node->left);
+    int right = height(node->right);
+
+    node->height = (left > right ? left : right) + 1;
+
+    if (left - right > 1)
+    {
+        if (height(node->left->left) < height(node->left->right))
+        {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+
+    if (right - left > 1)
+    {
+        if (height(node->right->right) < height(node->right->left))
+        {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+
+    return node;
+}
+
+VirtualArea *VirtualAreaTree::rotateLeft(VirtualArea *node)
+{
+    VirtualArea *right = node->right;
+
+    node->right = right->left;
+    right->left = node;
+
+    balance(node);
+    return balance(right);
+}
+
+VirtualArea *VirtualAreaTree::rotateRight(VirtualArea *node)
+{
+    VirtualArea *left = node->left;
+
+    node->left = left->right;
+    left->right = node;
+
+    balance(node);
+    return balance(left);
+}
+
+int VirtualAreaTree::height(VirtualArea *node)
+{
+    return node ? node->height : 0;
+}
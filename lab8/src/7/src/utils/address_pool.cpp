@@ -10,17 +10,32 @@ void AddressPool::initialize(char *bitmap, const int length, const int startAddr
 {
     resources.initialize(bitmap, length);
     this->startAddress = startAddress;
+    allocations = 0;
+    failures = 0;
+    releases = 0;
 }
 
 // 从地址池中分配count个连续页
 int AddressPool::allocate(const int count)
 {
     int start = resources.allocate(count);
+    if (start == -1)
+        ++failures;
+    else
+        ++allocations;
+
     return (start == -1) ? -1 : (start * PAGE_SIZE + startAddress);
 }
 
 // 释放若干页的空间
 void AddressPool::release(const int address, const int amount)
 {
+    ++releases;
     resources.release((address - startAddress) / PAGE_SIZE, amount);
+}
+
+// 预留若干页的空间
+void AddressPool::reserve(const int address, const int amount)
+{
+    resources.reserve((address - startAddress) / PAGE_SIZE, amount);
 }
\ No newline at end of file
@@ -4,6 +4,7 @@ global asm_hello_world
 global asm_lidt
 global asm_unhandled_interrupt
 global asm_halt
+global asm_idle
 global asm_out_port
 global asm_in_port
 global asm_time_interrupt_handler
@@ -20,7 +21,25 @@ global asm_ltr
 global asm_add_global_descriptor
 global asm_start_process
 global asm_update_cr3
+global asm_read_tsc
+global asm_divide
+global asm_page_fault_handler
+global asm_flush_tlb
+global asm_invlpg
+global asm_read_cr3
+global asm_flush_tlb_global
+global asm_read_cr4
+global asm_write_cr4
+global asm_memset
+global asm_memcpy
+global asm_memmove
+global asm_strlen
+global asm_page_zero
+global asm_page_copy
+global asm_read_hard_disk
+global asm_write_hard_disk
 extern c_time_interrupt_handler
+extern c_page_fault_handler
 extern system_call_table
 ASM_UNHANDLED_INTERRUPT_INFO db 'Unhandled interrupt happened, halt...'
                              db 0
@@ -36,6 +55,363 @@ asm_update_cr3:
     mov cr3, eax
     pop eax
     ret
+; uint64 asm_read_tsc()
+; 读取时间戳计数器，高32位在edx中，低32位在eax中
+asm_read_tsc:
+    rdtsc
+    ret
+; uint32 asm_divide(uint64 dividend, uint32 divisor)
+; 64位的被除数除以32位的除数，商必须小于2^32，内核不链接libgcc，不能直接使用64位除法
+asm_divide:
+    mov eax, [esp + 4]
+    mov edx, [esp + 8]
+    div dword[esp + 12]
+    ret
+; void asm_flush_tlb()
+asm_flush_tlb:
+    push eax
+    mov eax, cr3
+    mov cr3, eax
+    pop eax
+    ret
+; int asm_read_cr3()
+asm_read_cr3:
+    mov eax, cr3
+    ret
+; void asm_flush_tlb_global()
+; 清除再设置CR4.PGE，刷新包括全局页在内的整个TLB
+asm_flush_tlb_global:
+    push eax
+    mov eax, cr4
+    and eax, ~0x80
+    mov cr4, eax
+    or eax, 0x80
+    mov cr4, eax
+    pop eax
+    ret
+; int asm_read_cr4()
+asm_read_cr4:
+    mov eax, cr4
+    ret
+; void asm_write_cr4(int cr4)
+; 改变CR4.PGE时处理器刷新整个TLB
+asm_write_cr4:
+    push eax
+    mov eax, [esp + 4 * 2]
+    mov cr4, eax
+    pop eax
+    ret
+; void asm_invlpg(int address)
+; 使address所在页的TLB项失效
+asm_invlpg:
+    push eax
+    mov eax, [esp + 4 * 2]
+    invlpg [eax]
+    pop eax
+    ret
+
+; void asm_memset(void *memory, int value, int length)
+; 将从memory开始的length个字节设置为value的低8位
+; 先按字节对齐目的地址，再以4字节为单位写入，最后写入剩余的字节
+asm_memset:
+    push ebp
+    mov ebp, esp
+    push edi
+    push ecx
+    push edx
+
+    cld
+    mov edi, [ebp + 4 * 2]
+    movzx eax, byte[ebp + 4 * 3]
+    mov edx, [ebp + 4 * 4]
+    imul eax, eax, 0x01010101 ; 4个字节都是value
+
+    cmp edx, 16
+    jb .tail
+
+    mov ecx, edi
+    neg ecx
+    and ecx, 3   ; 对齐所需的字节数
+    sub edx, ecx
+    rep stosb
+
+    mov ecx, edx
+    shr ecx, 2
+    rep stosd
+    and edx, 3
+  .tail:
+    mov ecx, edx
+    rep stosb
+
+    pop edx
+    pop ecx
+    pop edi
+    pop ebp
+    ret
+
+; void asm_memcpy(void *dst, void *src, int length)
+; 将src开始的length个字节复制到dst，两者不能重叠
+asm_memcpy:
+    push ebp
+    mov ebp, esp
+    push esi
+    push edi
+    push ecx
+    push edx
+
+    cld
+    mov edi, [ebp + 4 * 2]
+    mov esi, [ebp + 4 * 3]
+    mov edx, [ebp + 4 * 4]
+
+    cmp edx, 16
+    jb .tail
+
+    mov ecx, edi
+    neg ecx
+    and ecx, 3   ; 按目的地址对齐
+    sub edx, ecx
+    rep movsb
+
+    mov ecx, edx
+    shr ecx, 2
+    rep movsd
+    and edx, 3
+  .tail:
+    mov ecx, edx
+    rep movsb
+
+    pop edx
+    pop ecx
+    pop edi
+    pop esi
+    pop ebp
+    ret
+
+; void asm_memmove(void *dst, void *src, int length)
+; 将src开始的length个字节复制到dst，两者可以重叠
+asm_memmove:
+    push ebp
+    mov ebp, esp
+    push esi
+    push edi
+    push ecx
+    push edx
+
+    mov edi, [ebp + 4 * 2]
+    mov esi, [ebp + 4 * 3]
+    mov edx, [ebp + 4 * 4]
+
+    ; dst不在(src, src + length)之间时，从前向后复制不会覆盖未复制的字节
+    mov eax, edi
+    sub eax, esi
+    cmp eax, edx
+    jae .forward
+
+    ; 从后向前复制，先复制末尾不足4字节的部分
+    std
+    lea esi, [esi + edx - 1]
+    lea edi, [edi + edx - 1]
+    mov ecx, edx
+    and ecx, 3
+    rep movsb
+    sub esi, 3
+    sub edi, 3
+    mov ecx, edx
+    shr ecx, 2
+    rep movsd
+    cld
+    jmp .done
+
+  .forward:
+    cld
+    mov ecx, edx
+    shr ecx, 2
+    rep movsd
+    mov ecx, edx
+    and ecx, 3
+    rep movsb
+
+  .done:
+    pop edx
+    pop ecx
+    pop edi
+    pop esi
+    pop ebp
+    ret
+
+; int asm_strlen(const char *str)
+asm_strlen:
+    push edi
+    push ecx
+
+    cld
+    mov edi, [esp + 4 * 3]
+    xor eax, eax
+    mov ecx, -1
+    repne scasb   ; 找到'\0'
+    mov eax, -2
+    sub eax, ecx  ; 扫描的字节数减去'\0'
+
+    pop ecx
+    pop edi
+    ret
+
+; void asm_page_zero(void *page)
+; 将4KB对齐的页清零
+asm_page_zero:
+    push edi
+    push ecx
+
+    cld
+    mov edi, [esp + 4 * 3]
+    xor eax, eax
+    mov ecx, 1024
+    rep stosd
+
+    pop ecx
+    pop edi
+    ret
+
+; void asm_page_copy(void *dst, void *src)
+; 复制4KB对齐的页
+asm_page_copy:
+    push esi
+    push edi
+    push ecx
+
+    cld
+    mov edi, [esp + 4 * 4]
+    mov esi, [esp + 4 * 5]
+    mov ecx, 1024
+    rep movsd
+
+    pop ecx
+    pop edi
+    pop esi
+    ret
+
+; void asm_read_hard_disk(void *memory, int block)
+; 读取逻辑扇区号为block的扇区到memory
+asm_read_hard_disk:
+    push ebp
+    mov ebp, esp
+    pushad
+
+    mov ebx, [ebp + 4 * 3] ; 逻辑扇区号
+    mov ah, 0x20           ; 读命令
+    call asm_select_sector
+
+    mov edi, [ebp + 4 * 2]
+    mov ecx, 256 ; 每次读取一个字，2个字节，因此读取256次即可
+    mov edx, 0x1f0
+  .readw:
+    in ax, dx
+    mov [edi], ax
+    add edi, 2
+    loop .readw
+
+    popad
+    pop ebp
+    ret
+
+; void asm_write_hard_disk(void *memory, int block)
+; 将memory开始的512个字节写入逻辑扇区号为block的扇区
+asm_write_hard_disk:
+    push ebp
+    mov ebp, esp
+    pushad
+
+    mov ebx, [ebp + 4 * 3] ; 逻辑扇区号
+    mov ah, 0x30           ; 写命令
+    call asm_select_sector
+
+    mov esi, [ebp + 4 * 2]
+    mov ecx, 256
+    mov edx, 0x1f0
+  .writew:
+    mov ax, [esi]
+    out dx, ax
+    add esi, 2
+    loop .writew
+
+    ; 等待硬盘写入完成
+    mov edx, 0x1f7
+  .waits:
+    in al, dx
+    test al, 0x80
+    jnz .waits
+
+    popad
+    pop ebp
+    ret
+
+; 向硬盘发送命令ah，LBA28地址为ebx，等待硬盘准备好传输数据
+asm_select_sector:
+    mov edx, 0x1f2
+    mov al, 1
+    out dx, al    ; 读写1个扇区
+
+    inc edx       ; 0x1f3
+    mov al, bl
+    out dx, al    ; LBA地址7~0
+
+    inc edx       ; 0x1f4
+    mov al, bh
+    out dx, al    ; LBA地址15~8
+
+    shr ebx, 16
+    inc edx       ; 0x1f5
+    mov al, bl
+    out dx, al    ; LBA地址23~16
+
+    inc edx       ; 0x1f6
+    mov al, bh
+    and al, 0x0f
+    or al, 0xe0   ; LBA地址27~24，LBA模式，主硬盘
+    out dx, al
+
+    inc edx       ; 0x1f7
+    mov al, ah
+    out dx, al
+
+  .waits:
+    in al, dx     ; dx = 0x1f7
+    and al, 0x88
+    cmp al, 0x08
+    jnz .waits    ; BSY=0且DRQ=1时硬盘准备好
+
+    ret
+
+; void asm_page_fault_handler()
+asm_page_fault_handler:
+    pushad
+    push ds
+    push es
+    push fs
+    push gs
+
+    mov eax, DATA_SELECTOR
+    mov ds, eax
+    mov es, eax
+    mov eax, VIDEO_SELECTOR
+    mov gs, eax
+
+    push dword[esp + 13 * 4] ; 引起缺页的指令地址
+    mov eax, cr2
+    push eax                 ; 引起缺页的线性地址
+    push dword[esp + 14 * 4] ; 错误码
+    call c_page_fault_handler
+    add esp, 3 * 4
+
+    pop gs
+    pop fs
+    pop es
+    pop ds
+    popad
+    add esp, 4 ; 弹出错误码
+    iret
+
 asm_start_process:
     ;jmp $
     mov eax, dword[esp+4]
@@ -361,4 +737,11 @@ asm_hello_world:
     ret
 
 asm_halt:
-    jmp $
\ No newline at end of file
+    jmp $
+
+; void asm_idle()
+; 开中断后停机，sti的下一条指令执行前不响应中断，因此不会错过停机前到达的中断
+asm_idle:
+    sti
+    hlt
+    ret
\ No newline at end of file
@@ -10,12 +10,14 @@ void BitMap::initialize(char *bitmap, const int length)
 {
     this->bitmap = bitmap;
     this->length = length;
+    this->hint = 0;
 
-    int bytes = ceil(length, 8);
+    // 按32位字清零
+    int words = ceil(length, 32);
 
-    for (int i = 0; i < bytes; ++i)
+    for (int i = 0; i < words; ++i)
     {
-        bitmap[i] = 0;
+        ((uint32 *)bitmap)[i] = 0;
     }
 }
 
@@ -44,52 +46,155 @@ void BitMap::set(const int index, const bool status)
 
 int BitMap::allocate(const int count)
 {
-    if (count == 0)
+    if (count <= 0 || count > length)
         return -1;
 
-    int index, empty, start;
+    // 从上次分配结束的位置开始查找
+    int start = search(hint, length, count);
+
+    // 游标之后不存在连续的count个资源，回到开头查找
+    if (start == -1 && hint)
+    {
+        int to = hint + count - 1;
+        start = search(0, to < length ? to : length, count);
+    }
+
+    if (start == -1)
+        return -1;
+
+    setRange(start, count, true);
+
+    hint = start + count;
+    if (hint >= length)
+        hint = 0;
+
+    return start;
+}
+
+void BitMap::release(const int index, const int count)
+{
+    setRange(index, count, false);
+}
+
+void BitMap::reserve(const int index, const int count)
+{
+    setRange(index, count, true);
+}
+
+void BitMap::countFree(int &free, int &largest) const
+{
+    int index = findFree(0, length);
+    int end;
+
+    free = 0;
+    largest = 0;
 
-    index = 0;
     while (index < length)
     {
-        // 越过已经分配的资源
-        while (index < length && get(index))
-            ++index;
+        end = findUsed(index, length);
+        free += end - index;
+        if (end - index > largest)
+        {
+            largest = end - index;
+        }
+        index = findFree(end, length);
+    }
+}
 
-        // 不存在连续的count个资源
-        if (index == length)
-            return -1;
+int BitMap::findFree(int index, const int limit) const
+{
+    uint32 *words = (uint32 *)bitmap;
+    uint32 word;
 
-        // 找到1个未分配的资源
-        // 检查是否存在从index开始的连续count个资源
-        empty = 0;
-        start = index;
-        while ((index < length) && (!get(index)) && (empty < count))
+    while (index < limit)
+    {
+        // 取反后为1的位对应未分配的资源，屏蔽index之前的位
+        word = ~words[index >> 5] & (0xffffffff << (index & 31));
+        if (word)
         {
-            ++empty;
-            ++index;
+            // bsf找到最低的为1的位
+            index = (index & ~31) + __builtin_ctz(word);
+            return index < limit ? index : limit;
         }
 
-        // 存在连续的count个资源
-        if (empty == count)
+        // 整个字都已分配，一次越过
+        index = (index & ~31) + 32;
+    }
+
+    return limit;
+}
+
+int BitMap::findUsed(int index, const int limit) const
+{
+    uint32 *words = (uint32 *)bitmap;
+    uint32 word;
+
+    while (index < limit)
+    {
+        word = words[index >> 5] & (0xffffffff << (index & 31));
+        if (word)
         {
-            for (int i = 0; i < count; ++i)
-            {
-                set(start + i, true);
-            }
+            index = (index & ~31) + __builtin_ctz(word);
+            return index < limit ? index : limit;
+        }
 
+        // 整个字都未分配，一次越过
+        index = (index & ~31) + 32;
+    }
+
+    return limit;
+}
+
+int BitMap::search(const int from, const int to, const int count) const
+{
+    int index, start, end;
+
+    index = from;
+    while (index < to)
+    {
+        // 越过已经分配的资源
+        start = findFree(index, to);
+
+        // 不存在连续的count个资源
+        if (to - start < count)
+            return -1;
+
+        // 检查从start开始的count个资源中是否有已分配的资源
+        end = findUsed(start, start + count);
+        if (end == start + count)
             return start;
-        }
+
+        index = end;
     }
 
     return -1;
 }
 
-void BitMap::release(const int index, const int count)
+void BitMap::setRange(const int index, const int count, const bool status)
 {
-    for (int i = 0; i < count; ++i)
+    uint32 *words = (uint32 *)bitmap;
+    uint32 mask;
+    int end = index + count;
+    int offset, amount;
+
+    for (int i = index; i < end; i += amount)
     {
-        set(index + i, false);
+        offset = i & 31;
+        amount = 32 - offset;
+        if (amount > end - i)
+            amount = end - i;
+
+        // 首尾不足一个字的部分使用掩码，中间部分整字设置
+        mask = (amount == 32) ? 0xffffffff : (((1u << amount) - 1) << offset);
+
+        if (status)
+        {
+            words[i >> 5] |= mask;
+        }
+        else
+        {
+            words[i >> 5] &= ~mask;
+        }
     }
 }
 
@@ -0,0 +1,200 @@
+#include "buddy.h"
+#include "os_constant.h"
+
+BuddyAllocator::BuddyAllocator()
+{
+}
+
+void BuddyAllocator::initialize(char *metadata, const int length, const int startAddress)
+{
+    this->pages = (BuddyPage *)metadata;
+    this->length = length;
+    this->startAddress = startAddress;
+    this->allocations = 0;
+    this->failures = 0;
+    this->releases = 0;
+
+    for (int i = 0; i <= BUDDY_MAX_ORDER; ++i)
+    {
+        freeList[i] = -1;
+        freeBlocks[i] = 0;
+    }
+
+    for (int i = 0; i < length; ++i)
+    {
+        pages[i].previous = pages[i].next = -1;
+        pages[i].order = 0;
+        pages[i].free = false;
+    }
+}
+
+int BuddyAllocator::allocate(const int count)
+{
+    if (count <= 0)
+    {
+        ++failures;
+        return -1;
+    }
+
+    // 满足count个页的最小的阶
+    int order = 0;
+    while ((1 << order) < count)
+        ++order;
+
+    if (order > BUDDY_MAX_ORDER)
+    {
+        ++failures;
+        return -1;
+    }
+
+    // 找到不小于order阶的非空链表
+    int current = order;
+    while (current <= BUDDY_MAX_ORDER && freeList[current] == -1)
+        ++current;
+
+    if (current > BUDDY_MAX_ORDER)
+    {
+        ++failures;
+        return -1;
+    }
+
+    int index = freeList[current];
+    removeFree(index);
+
+    // 将大块逐级对半分裂，后一半放回低一阶的空闲链表
+    while (current > order)
+    {
+        --current;
+        pushFree(index + (1 << current), current);
+    }
+
+    // 归还多出来的页
+    if ((1 << order) > count)
+    {
+        releaseRange(index + count, (1 << order) - count);
+    }
+
+    ++allocations;
+    return startAddress + index * PAGE_SIZE;
+}
+
+void BuddyAllocator::release(const int address, const int amount)
+{
+    ++releases;
+    releaseRange((address - startAddress) / PAGE_SIZE, amount);
+}
+
+int BuddyAllocator::getFreePages(const int order) const
+{
+    return freeBlocks[order] << order;
+}
+
+void BuddyAllocator::countFree(int &free, int &largest) const
+{
+    free = 0;
+    largest = 0;
+
+    for (int order = 0; order <= BUDDY_MAX_ORDER; ++order)
+    {
+        free += getFreePages(order);
+        if (freeBlocks[order])
+        {
+            largest = 1 << order;
+        }
+    }
+}
+
+int BuddyAllocator::metadataSize(const int length)
+{
+    return length * sizeof(BuddyPage);
+}
+
+void BuddyAllocator::pushFree(const int index, const int order)
+{
+    BuddyPage &page = pages[index];
+
+    page.order = order;
+    page.free = true;
+    page.previous = -1;
+    page.next = freeList[order];
+
+    if (page.next != -1)
+    {
+        pages[page.next].previous = index;
+    }
+
+    freeList[order] = index;
+    ++freeBlocks[order];
+}
+
+void BuddyAllocator::removeFree(const int index)
+{
+    BuddyPage &page = pages[index];
+
+    if (page.previous != -1)
+    {
+        pages[page.previous].next = page.next;
+    }
+    else
+    {
+        freeList[(int)page.order] = page.next;
+    }
+
+    if (page.next != -1)
+    {
+        pages[page.next].previous = page.previous;
+    }
+
+    --freeBlocks[(int)page.order];
+    page.free = false;
+    page.previous = page.next = -1;
+}
+
+void BuddyAllocator::releaseBlock(int index, int order)
+{
+    int buddy;
+
+    while (order < BUDDY_MAX_ORDER)
+    {
+        // 伙伴块的序号只在第order位上不同
+        buddy = index ^ (1 << order);
+
+        // 伙伴块不完整、未空闲或已被分裂时停止合并
+        if (buddy + (1 << order) > length ||
+            !pages[buddy].free ||
+            pages[buddy].order != order)
+        {
+            break;
+        }
+
+        removeFree(buddy);
+        if (buddy < index)
+        {
+            index = buddy;
+        }
+        ++order;
+    }
+
+    pushFree(index, order);
+}
+
+void BuddyAllocator::releaseRange(int index, int count)
+{
+    int order;
+
+    // 将[index, index + count)分解为若干个对齐的块后逐个释放
+    while (count > 0)
+    {
+        order = 0;
+        while (order < BUDDY_MAX_ORDER &&
+               (index & ((2 << order) - 1)) == 0 &&
+               (2 << order) <= count)
+        {
+            ++order;
+        }
+
+        releaseBlock(index, order);
+        index += (1 << order);
+        count -= (1 << order);
+    }
+}
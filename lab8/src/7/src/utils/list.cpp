@@ -2,169 +2,111 @@
 
 List::List()
 {
-    head.next = head.previous = 0;
+    initialize();
 }
 
 void List::initialize()
 {
-    head.next = head.previous = 0;
+    head.next = head.previous = &head;
+    length = 0;
 }
 
 int List::size()
 {
-    ListItem *temp = head.next;
-    int counter = 0;
-
-    while (temp)
-    {
-        temp = temp->next;
-        ++counter;
-    }
-
-    return counter;
+    return length;
 }
 
 bool List::empty()
 {
-    return size() == 0;
+    return length == 0;
 }
 
 ListItem *List::back()
 {
-    ListItem *temp = head.next;
-    if (!temp)
-        return nullptr;
-
-    while (temp->next)
-    {
-        temp = temp->next;
-    }
-
-    return temp;
+    return length ? head.previous : nullptr;
 }
 
 void List::push_back(ListItem *itemPtr)
 {
-    ListItem *temp = back();
-    if (temp == nullptr)
-        temp = &head;
-    temp->next = itemPtr;
-    itemPtr->previous = temp;
-    itemPtr->next = nullptr;
+    link(head.previous, itemPtr);
 }
 
 void List::pop_back()
 {
-    ListItem *temp = back();
-    if (temp)
+    if (length)
     {
-        temp->previous->next = nullptr;
-        temp->previous = temp->next = nullptr;
+        unlink(head.previous);
     }
 }
 
 ListItem *List::front()
 {
-    return head.next;
+    return length ? head.next : nullptr;
 }
 
 void List::push_front(ListItem *itemPtr)
 {
-    ListItem *temp = head.next;
-    if (temp)
-    {
-        temp->previous = itemPtr;
-    }
-    head.next = itemPtr;
-    itemPtr->previous = &head;
-    itemPtr->next = temp;
+    link(&head, itemPtr);
 }
 
 void List::pop_front()
 {
-    ListItem *temp = head.next;
-    if (temp)
+    if (length)
     {
-        if (temp->next)
-        {
-            temp->next->previous = &head;
-        }
-        head.next = temp->next;
-        temp->previous = temp->next = nullptr;
+        unlink(head.next);
     }
 }
 
 void List::insert(int pos, ListItem *itemPtr)
 {
-    if (pos == 0)
+    if (pos == length)
     {
-        push_front(itemPtr);
+        push_back(itemPtr);
     }
-    else
+    else if (pos >= 0 && pos < length)
     {
-        int length = size();
-        if (pos == length)
-        {
-            push_back(itemPtr);
-        }
-        else if (pos < length)
-        {
-            ListItem *temp = at(pos);
-
-            itemPtr->previous = temp->previous;
-            itemPtr->next = temp;
-            temp->previous->next = itemPtr;
-            temp->previous = itemPtr;
-        }
+        link(at(pos)->previous, itemPtr);
     }
 }
 
 void List::erase(int pos)
 {
-    if (pos == 0)
+    ListItem *temp = at(pos);
+    if (temp)
     {
-        pop_front();
-    }
-    else
-    {
-        int length = size();
-        if (pos < length)
-        {
-            ListItem *temp = at(pos);
-
-            temp->previous->next = temp->next;
-            if (temp->next)
-            {
-                temp->next->previous = temp->previous;
-            }
-        }
+        unlink(temp);
     }
 }
 
 void List::erase(ListItem *itemPtr)
 {
-    ListItem *temp = head.next;
+    unlink(itemPtr);
+}
 
-    while (temp && temp != itemPtr)
+ListItem *List::at(int pos)
+{
+    if (pos < 0 || pos >= length)
     {
-        temp = temp->next;
+        return nullptr;
     }
 
-    if (temp)
+    // 从距离较近的一端开始查找
+    ListItem *temp;
+    if (pos < length / 2)
     {
-        temp->previous->next = temp->next;
-        if (temp->next)
+        temp = head.next;
+        for (int i = 0; i < pos; ++i)
         {
-            temp->next->previous = temp->previous;
+            temp = temp->next;
         }
     }
-}
-ListItem *List::at(int pos)
-{
-    ListItem *temp = head.next;
-
-    for (int i = 0; (i < pos) && temp; ++i, temp = temp->next)
+    else
     {
+        temp = head.previous;
+        for (int i = length - 1; i > pos; --i)
+        {
+            temp = temp->previous;
+        }
     }
 
     return temp;
@@ -174,18 +116,38 @@ int List::find(ListItem *itemPtr)
 {
     int pos = 0;
     ListItem *temp = head.next;
-    while (temp && temp != itemPtr)
+
+    while (temp != &head)
     {
+        if (temp == itemPtr)
+        {
+            return pos;
+        }
         temp = temp->next;
         ++pos;
     }
 
-    if (temp && temp == itemPtr)
-    {
-        return pos;
-    }
-    else
-    {
-        return -1;
-    }
-}
\ No newline at end of file
+    return -1;
+}
+
+ListItem *List::next(ListItem *itemPtr)
+{
+    return itemPtr->next == &head ? nullptr : itemPtr->next;
+}
+
+void List::link(ListItem *previous, ListItem *itemPtr)
+{
+    itemPtr->previous = previous;
+    itemPtr->next = previous->next;
+    previous->next->previous = itemPtr;
+    previous->next = itemPtr;
+    ++length;
+}
+
+void List::unlink(ListItem *itemPtr)
+{
+    itemPtr->previous->next = itemPtr->next;
+    itemPtr->next->previous = itemPtr->previous;
+    itemPtr->previous = itemPtr->next = nullptr;
+    --length;
+}
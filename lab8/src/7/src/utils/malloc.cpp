@@ -0,0 +1,195 @@
+#include "malloc.h"
+#include "os_constant.h"
+#include "syscall.h"
+
+// 管理信息位于堆的第一页，该页由内核在创建进程时清零
+static MallocArena *getArena()
+{
+    MallocArena *arena = (MallocArena *)USER_HEAP_START;
+
+    if (!arena->end)
+    {
+        arena->top = (char *)USER_HEAP_START + ((sizeof(MallocArena) + 7) & ~7);
+        arena->end = (char *)sbrk(0);
+    }
+
+    return arena;
+}
+
+// 块之后的第一个字节
+static char *blockEnd(MallocBlock *block)
+{
+    return (char *)(block + 1) + block->size;
+}
+
+// 将大块按地址顺序放回空闲链表，与相邻的空闲块合并
+// 合并后位于已划分区域的末尾时，归还给尚未划分的区域
+static void releaseLarge(MallocArena *arena, MallocBlock *block)
+{
+    MallocBlock **link = &(arena->largeList);
+    MallocBlock **previousLink = nullptr;
+    MallocBlock *previous = nullptr;
+    while (*link && *link < block)
+    {
+        previousLink = link;
+        previous = *link;
+        link = &(previous->next);
+    }
+
+    MallocBlock *next = *link;
+    if (next && blockEnd(block) == (char *)next)
+    {
+        block->size += sizeof(MallocBlock) + next->size;
+        next = next->next;
+    }
+
+    if (previous && blockEnd(previous) == (char *)block)
+    {
+        previous->size += sizeof(MallocBlock) + block->size;
+        block = previous;
+        link = previousLink;
+    }
+
+    if (blockEnd(block) == arena->top)
+    {
+        arena->top = (char *)block;
+        *link = next;
+    }
+    else
+    {
+        block->next = next;
+        *link = block;
+    }
+}
+
+// 从堆中尚未划分的区域中切出total个字节，必要时通过sbrk扩展堆
+static MallocBlock *carve(MallocArena *arena, int total)
+{
+    if (arena->top + total > arena->end)
+    {
+        int grow = total - (arena->end - arena->top);
+        if (grow < MALLOC_GROW_SIZE)
+        {
+            grow = MALLOC_GROW_SIZE;
+        }
+
+        if (sbrk(grow) == -1)
+        {
+            return nullptr;
+        }
+        arena->end += grow;
+    }
+
+    MallocBlock *block = (MallocBlock *)arena->top;
+    arena->top += total;
+    return block;
+}
+
+void *malloc(int size)
+{
+    if (size <= 0)
+    {
+        return nullptr;
+    }
+
+    MallocArena *arena = getArena();
+    MallocBlock *block;
+
+    if (size <= MALLOC_MAX_SIZE)
+    {
+        // 找到能容纳size个字节的最小的大小类别
+        int index = 0;
+        int classSize = MALLOC_MIN_SIZE;
+        while (classSize < size)
+        {
+            ++index;
+            classSize *= 2;
+        }
+
+        block = arena->freeList[index];
+        if (block)
+        {
+            arena->freeList[index] = block->next;
+        }
+        else
+        {
+            block = carve(arena, sizeof(MallocBlock) + classSize);
+            if (!block)
+            {
+                return nullptr;
+            }
+            block->size = classSize;
+        }
+    }
+    else
+    {
+        size = (size + 7) & ~7;
+
+        // 大块内存首次适配
+        MallocBlock **link = &(arena->largeList);
+        block = arena->largeList;
+        while (block && block->size < size)
+        {
+            link = &(block->next);
+            block = block->next;
+        }
+
+        if (block)
+        {
+            // 剩余部分仍是大块时分割，剩余部分留在链表中原来的位置
+            int rest = block->size - size - (int)sizeof(MallocBlock);
+            if (rest > MALLOC_MAX_SIZE)
+            {
+                MallocBlock *remainder = (MallocBlock *)((char *)(block + 1) + size);
+                remainder->size = rest;
+                remainder->next = block->next;
+                *link = remainder;
+                block->size = size;
+            }
+            else
+            {
+                *link = block->next;
+            }
+        }
+        else
+        {
+            block = carve(arena, sizeof(MallocBlock) + size);
+            if (!block)
+            {
+                return nullptr;
+            }
+            block->size = size;
+        }
+    }
+
+    return (void *)(block + 1);
+}
+
+void free(void *address)
+{
+    if (!address)
+    {
+        return;
+    }
+
+    MallocArena *arena = getArena();
+    MallocBlock *block = (MallocBlock *)address - 1;
+
+    if (block->size <= MALLOC_MAX_SIZE)
+    {
+        int index = 0;
+        int classSize = MALLOC_MIN_SIZE;
+        while (classSize < block->size)
+        {
+            ++index;
+            classSize *= 2;
+        }
+
+        block->next = arena->freeList[index];
+        arena->freeList[index] = block;
+    }
+    else
+    {
+        releaseLarge(arena, block);
+    }
+}
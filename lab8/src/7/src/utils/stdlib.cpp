@@ -1,4 +1,5 @@
 #include "os_type.h"
+#include "asm_utils.h"
 
 template <typename T>
 void swap(T &x, T &y)
@@ -47,9 +48,9 @@ void itos(char *numStr, uint32 num, uint32 mod)
 
 void memset(void *memory, char value, int length)
 {
-    for (int i = 0; i < length; ++i)
+    if (length > 0)
     {
-        ((char *)memory)[i] = value;
+        asm_memset(memory, value, length);
     }
 }
 
@@ -60,17 +61,29 @@ int ceil(const int dividend, const int divisor)
 
 void memcpy(void *src, void *dst, uint32 length)
 {
-    for (uint32 i = 0; i < length; ++i)
-    {
-        ((char *)dst)[i] = ((char *)src)[i];
-    }
+    asm_memcpy(dst, src, length);
+}
+
+void memmove(void *src, void *dst, uint32 length)
+{
+    asm_memmove(dst, src, length);
+}
+
+int strlen(const char *str)
+{
+    return asm_strlen(str);
 }
 
 void strcpy(const char *src, char *dst) {
-    int i = 0;
-    while(src[i]) {
-        dst[i] = src[i];
-        ++i;
-    }
-    dst[i] = '\0';
+    asm_memcpy(dst, src, asm_strlen(src) + 1);
+}
+
+void pageZero(void *page)
+{
+    asm_page_zero(page);
+}
+
+void pageCopy(void *src, void *dst)
+{
+    asm_page_copy(dst, src);
 }
\ No newline at end of file